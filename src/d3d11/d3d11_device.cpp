@@ -37,7 +37,8 @@ namespace dxvk {
     m_dxvkAdapter   (m_dxvkDevice->adapter()),
     m_d3d11Formats  (m_dxvkAdapter),
     m_d3d11Options  (m_dxvkAdapter->instance()->config()),
-    m_dxbcOptions   (m_dxvkDevice, m_d3d11Options) {
+    m_dxbcOptions   (m_dxvkDevice, m_d3d11Options),
+    m_shaderModules (m_d3d11Options.numShaderThreads) {
     m_initializer = new D3D11Initializer(m_dxvkDevice);
     m_context     = new D3D11ImmediateContext(this, m_dxvkDevice);
     m_d3d10Device = new D3D10Device(this, m_context);
@@ -412,9 +413,13 @@ namespace dxvk {
     try {
       DxbcReader dxbcReader(reinterpret_cast<const char*>(
         pShaderBytecodeWithInputSignature), BytecodeLength);
-      DxbcModule dxbcModule(dxbcReader);
       
-      const Rc<DxbcIsgn> inputSignature = dxbcModule.isgn();
+      // Only the input signature is needed here, so
+      // there is no need to parse the shader code
+      const Rc<DxbcIsgn> inputSignature = DxbcModule::readInputSignature(dxbcReader);
+      
+      if (inputSignature == nullptr)
+        throw DxvkError("D3D11Device::CreateInputLayout: No input signature");
 
       uint32_t attrMask = 0;
       uint32_t bindMask = 0;
@@ -1350,6 +1355,11 @@ namespace dxvk {
     DxvkDeviceFeatures supported = adapter->features();
     DxvkDeviceFeatures enabled   = {};
 
+    // Robust buffer access can be replaced by bounds
+    // checks in shaders, which only cover the buffer
+    // access types that D3D11 defines behaviour for
+    const D3D11Options options(adapter->instance()->config());
+
     enabled.core.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
     enabled.core.pNext = nullptr;
 
@@ -1368,7 +1378,7 @@ namespace dxvk {
       enabled.core.features.samplerAnisotropy                     = VK_TRUE;
       enabled.core.features.shaderClipDistance                    = VK_TRUE;
       enabled.core.features.shaderCullDistance                    = VK_TRUE;
-      enabled.core.features.robustBufferAccess                    = VK_TRUE;
+      enabled.core.features.robustBufferAccess                    = options.shaderBoundsChecks ? VK_FALSE : VK_TRUE;
     }
     
     if (featureLevel >= D3D_FEATURE_LEVEL_9_2) {
@@ -8,7 +8,11 @@ namespace dxvk {
     this->allowMapFlagNoWait    = config.getOption<bool>("d3d11.allowMapFlagNoWait", false);
     this->dcSingleUseMode       = config.getOption<bool>("d3d11.dcSingleUseMode", true);
     this->zeroInitWorkgroupMemory = config.getOption<bool>("d3d11.zeroInitWorkgroupMemory", false);
+    this->optimizeShaders       = config.getOption<bool>("d3d11.optimizeShaders", false);
+    this->parallelForkPhases    = config.getOption<bool>("d3d11.parallelForkPhases", false);
+    this->shaderBoundsChecks    = config.getOption<bool>("d3d11.shaderBoundsChecks", false);
     this->maxTessFactor         = config.getOption<int32_t>("d3d11.maxTessFactor", 0);
+    this->numShaderThreads      = config.getOption<int32_t>("d3d11.numShaderThreads", 0);
     this->samplerAnisotropy     = config.getOption<int32_t>("d3d11.samplerAnisotropy", -1);
     this->deferSurfaceCreation  = config.getOption<bool>("dxgi.deferSurfaceCreation", false);
     this->numBackBuffers        = config.getOption<int32_t>("dxgi.numBackBuffers", 0);
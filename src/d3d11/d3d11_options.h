@@ -31,6 +31,31 @@ namespace dxvk {
     /// TGSM in compute shaders before reading it.
     bool zeroInitWorkgroupMemory;
 
+    /// Optimize generated SPIR-V
+    ///
+    /// Removes redundant loads and stores, folds
+    /// constants and removes dead code before the
+    /// shader gets passed to the driver. Also removes
+    /// outputs that the next shader stage does not use.
+    bool optimizeShaders;
+
+    /// Run hull shader fork phases in parallel
+    ///
+    /// Distributes the fork phases of hull shaders across
+    /// control point invocations instead of running all
+    /// of them in the first invocation of each patch.
+    /// Experimental, thus disabled by default.
+    bool parallelForkPhases;
+
+    /// Perform buffer bounds checks in shaders
+    ///
+    /// Creates the device without robust buffer access
+    /// and lets the shader compiler emit explicit bounds
+    /// checks for raw, structured and typed buffer loads
+    /// and stores instead. Vertex and constant buffer
+    /// accesses will not be bounds-checked.
+    bool shaderBoundsChecks;
+
     /// Maximum tessellation factor.
     ///
     /// Limits tessellation factors in tessellation
@@ -38,6 +63,13 @@ namespace dxvk {
     /// supported, other values will be ignored.
     int32_t maxTessFactor;
 
+    /// Number of shader translation threads.
+    ///
+    /// Shaders are translated to SPIR-V in the background.
+    /// If this is 0, the number of threads is chosen
+    /// based on the number of available CPU cores.
+    int32_t numShaderThreads;
+
     /// Anisotropic filter override
     ///
     /// Enforces anisotropic filtering with the
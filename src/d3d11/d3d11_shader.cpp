@@ -3,43 +3,138 @@
 
 namespace dxvk {
   
-  D3D11CommonShader:: D3D11CommonShader() { }
-  D3D11CommonShader::~D3D11CommonShader() { }
-  
-  
-  D3D11CommonShader::D3D11CommonShader(
+  D3D11ShaderTranslation::D3D11ShaderTranslation(
           D3D11Device*    pDevice,
     const DxvkShaderKey*  pShaderKey,
     const DxbcModuleInfo* pDxbcModuleInfo,
-    const void*           pShaderBytecode,
-          size_t          BytecodeLength) {
-    const std::string name = pShaderKey->toString();
-    Logger::debug(str::format("Compiling shader ", name));
+    const DxbcModule&     Module,
+          size_t          BytecodeLength)
+  : m_device        (pDevice),
+    m_key           (*pShaderKey),
+    m_moduleInfo    (*pDxbcModuleInfo),
+    m_tessInfo      (),
+    m_module        (std::make_unique<DxbcModule>(Module)),
+    m_bytecodeLength(BytecodeLength) {
+    // The module info may be destroyed before the shader
+    // gets translated, so we need to copy the tess info
+    if (pDxbcModuleInfo->tess != nullptr) {
+      m_tessInfo = *pDxbcModuleInfo->tess;
+      m_moduleInfo.tess = &m_tessInfo;
+    }
+  }
+  
+  
+  D3D11ShaderTranslation::~D3D11ShaderTranslation() {
     
-    DxbcReader reader(
-      reinterpret_cast<const char*>(pShaderBytecode),
-      BytecodeLength);
+  }
+  
+  
+  Rc<DxvkShader> D3D11ShaderTranslation::GetShader() {
+    this->Wait();
+    return m_shader;
+  }
+  
+  
+  Rc<DxvkBuffer> D3D11ShaderTranslation::GetIcb() {
+    this->Wait();
+    return m_buffer;
+  }
+  
+  
+  void D3D11ShaderTranslation::Translate() {
+    State expected = State::Pending;
     
-    DxbcModule module(reader);
+    if (!m_state.compare_exchange_strong(expected, State::Running))
+      return;
+    
+    try {
+      this->TranslateShader();
+    } catch (const DxvkError& e) {
+      Logger::err(str::format("D3D11: Failed to translate shader ", m_key.toString()));
+      Logger::err(e.message());
+      
+      m_shader = nullptr;
+      m_buffer = nullptr;
+    }
+    
+    // The module, and with it the decoded instruction
+    // stream, is not needed anymore after translation
+    m_module = nullptr;
+    
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_state.store(State::Done, std::memory_order_release);
+    m_cond.notify_all();
+  }
+  
+  
+  void D3D11ShaderTranslation::Wait() {
+    if (m_state.load(std::memory_order_acquire) == State::Done)
+      return;
+    
+    // If no worker has picked up the shader yet, translate
+    // it on the calling thread rather than waiting for the
+    // worker threads to process all the preceding shaders
+    this->Translate();
+    
+    std::unique_lock<std::mutex> lock(m_mutex);
     
-    // If requested by the user, dump both the raw DXBC
-    // shader and the compiled SPIR-V module to a file.
+    m_cond.wait(lock, [this] {
+      return m_state.load() == State::Done;
+    });
+  }
+  
+  
+  void D3D11ShaderTranslation::TranslateShader() {
+    const std::string name = m_key.toString();
     const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
     
-    if (dumpPath.size() != 0) {
-      reader.store(std::ofstream(str::format(dumpPath, "/", name, ".dxbc"),
-        std::ios_base::binary | std::ios_base::trunc));
+    auto t0 = std::chrono::high_resolution_clock::now();
+    
+    // Stream output shaders are not cached since the xfb info
+    // contains pointers, which cannot be hashed meaningfully
+    Rc<DxvkShaderCache> shaderCache = m_device->GetDXVKDevice()->shaderCache();
+    
+    if (m_moduleInfo.xfb != nullptr)
+      shaderCache = nullptr;
+    
+    Sha1Hash cacheKey;
+    
+    if (shaderCache != nullptr) {
+      cacheKey = GetShaderCacheKey(&m_key, &m_moduleInfo);
+      m_shader = shaderCache->lookupShader(cacheKey);
     }
     
-    // Decide whether we need to create a pass-through
-    // geometry shader for vertex shader stream output
-    bool passthroughShader = pDxbcModuleInfo->xfb != nullptr
-      && module.programInfo().type() != DxbcProgramType::GeometryShader;
-
-    m_shader = passthroughShader
-      ? module.compilePassthroughShader(*pDxbcModuleInfo, name)
-      : module.compile                 (*pDxbcModuleInfo, name);
-    m_shader->setShaderKey(*pShaderKey);
+    if (m_shader == nullptr) {
+      Logger::debug(str::format("Compiling shader ", name));
+      
+      // Decide whether we need to create a pass-through
+      // geometry shader for vertex shader stream output
+      bool passthroughShader = m_moduleInfo.xfb != nullptr
+        && m_module->programInfo().type() != DxbcProgramType::GeometryShader;
+      
+      m_shader = passthroughShader
+        ? m_module->compilePassthroughShader(m_moduleInfo, name)
+        : m_module->compile                 (m_moduleInfo, name);
+      
+      if (shaderCache != nullptr)
+        shaderCache->addShader(cacheKey, m_shader);
+    }
+    
+    m_shader->setShaderKey(m_key);
+    m_shader = m_device->GetDXVKDevice()->registerShader(m_shader);
+    
+    auto t1 = std::chrono::high_resolution_clock::now();
+    
+    Rc<DxvkShaderStats> shaderStats = m_device->GetDXVKDevice()->shaderStats();
+    
+    if (shaderStats != nullptr) {
+      DxvkShaderStatsEntry stats;
+      stats.dxbcSize         = m_bytecodeLength;
+      stats.dxbcInstructions = m_module->instructionCount();
+      stats.spirvWords       = m_shader->getCodeSize() / sizeof(uint32_t);
+      stats.translateTimeUs  = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+      shaderStats->addShader(m_key, stats);
+    }
     
     if (dumpPath.size() != 0) {
       std::ofstream dumpStream(
@@ -64,18 +159,146 @@ namespace dxvk {
         | VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
         | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
       
-      m_buffer = pDevice->GetDXVKDevice()->createBuffer(info, memFlags);
+      m_buffer = m_device->GetDXVKDevice()->createBuffer(info, memFlags);
 
       std::memcpy(m_buffer->mapPtr(0),
         m_shader->shaderConstants().data(),
         m_shader->shaderConstants().sizeInBytes());
     }
-
-    pDevice->GetDXVKDevice()->registerShader(m_shader);
   }
 
   
-  D3D11ShaderModuleSet:: D3D11ShaderModuleSet() { }
+  Sha1Hash D3D11ShaderTranslation::GetShaderCacheKey(
+    const DxvkShaderKey*  pShaderKey,
+    const DxbcModuleInfo* pDxbcModuleInfo) {
+    // The shader key already identifies the original code, but
+    // the compiler options also affect the generated SPIR-V
+    const std::string keyString = pShaderKey->toString();
+    
+    float maxTessFactor = pDxbcModuleInfo->tess != nullptr
+      ? pDxbcModuleInfo->tess->maxTessFactor : 0.0f;
+    
+    std::array<Sha1Data, 3> chunks = {{
+      { keyString.data(),          keyString.size()                 },
+      { &pDxbcModuleInfo->options, sizeof(pDxbcModuleInfo->options) },
+      { &maxTessFactor,            sizeof(maxTessFactor)            },
+    }};
+    
+    return Sha1Hash::compute(chunks.size(), chunks.data());
+  }
+  
+  
+  D3D11CommonShader:: D3D11CommonShader() { }
+  D3D11CommonShader::~D3D11CommonShader() { }
+  
+  
+  D3D11CommonShader::D3D11CommonShader(
+          D3D11Device*    pDevice,
+    const DxvkShaderKey*  pShaderKey,
+    const DxbcModuleInfo* pDxbcModuleInfo,
+    const void*           pShaderBytecode,
+          size_t          BytecodeLength) {
+    const std::string name = pShaderKey->toString();
+    
+    DxbcReader reader(
+      reinterpret_cast<const char*>(pShaderBytecode),
+      BytecodeLength);
+    
+    // If requested by the user, dump the raw DXBC shader to
+    // a file. The SPIR-V module is dumped after translation.
+    const std::string dumpPath = env::getEnvVar("DXVK_SHADER_DUMP_PATH");
+    
+    if (dumpPath.size() != 0) {
+      reader.store(std::ofstream(str::format(dumpPath, "/", name, ".dxbc"),
+        std::ios_base::binary | std::ios_base::trunc));
+    }
+    
+    // Parsing and decoding the module is cheap compared to
+    // translating it, and lets us reject invalid byte code
+    // right away. The module copies all data it needs from
+    // the byte code.
+    DxbcModule module(reader);
+    module.decode();
+    
+    m_translation = new D3D11ShaderTranslation(
+      pDevice, pShaderKey, pDxbcModuleInfo, module, BytecodeLength);
+  }
+  
+  
+  D3D11ShaderTranslator::D3D11ShaderTranslator(int32_t NumThreads)
+  : m_numThreads(NumThreads) {
+    
+  }
+  
+  
+  D3D11ShaderTranslator::~D3D11ShaderTranslator() {
+    { std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+      m_cond.notify_all();
+    }
+    
+    for (auto& worker : m_workers)
+      worker.join();
+  }
+  
+  
+  void D3D11ShaderTranslator::QueueTranslation(
+    const Rc<D3D11ShaderTranslation>& pTranslation) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_workers.size() == 0)
+      this->StartWorkers();
+    
+    m_queue.push(pTranslation);
+    m_cond.notify_one();
+  }
+  
+  
+  void D3D11ShaderTranslator::StartWorkers() {
+    uint32_t numWorkers = dxvk::thread::hardware_concurrency();
+    
+    if (numWorkers <  1) numWorkers =  1;
+    if (numWorkers > 16) numWorkers = 16;
+    
+    if (m_numThreads > 0)
+      numWorkers = m_numThreads;
+    
+    Logger::info(str::format("D3D11: Using ", numWorkers, " shader translation threads"));
+    
+    for (uint32_t i = 0; i < numWorkers; i++)
+      m_workers.emplace_back([this] () { WorkerFunc(); });
+  }
+  
+  
+  void D3D11ShaderTranslator::WorkerFunc() {
+    env::setThreadName("dxvk-shader-tr");
+    
+    while (true) {
+      Rc<D3D11ShaderTranslation> translation;
+      
+      { std::unique_lock<std::mutex> lock(m_mutex);
+        
+        m_cond.wait(lock, [this] {
+          return m_stopped || !m_queue.empty();
+        });
+        
+        // Pending shaders can be discarded since nothing
+        // can use them once the device is destroyed
+        if (m_stopped)
+          return;
+        
+        translation = std::move(m_queue.front());
+        m_queue.pop();
+      }
+      
+      translation->Translate();
+    }
+  }
+  
+  
+  D3D11ShaderModuleSet::D3D11ShaderModuleSet(int32_t NumThreads)
+  : m_translator(NumThreads) { }
+  
   D3D11ShaderModuleSet::~D3D11ShaderModuleSet() { }
   
   
@@ -94,12 +317,23 @@ namespace dxvk {
     }
     
     // This shader has not been compiled yet, so we have to create a
-    // new module. This takes a while, so we won't lock the structure.
+    // new module. Parsing the shader may fail, so do it before
+    // inserting the module into the lookup table.
     D3D11CommonShader module(pDevice, pShaderKey,
       pDxbcModuleInfo, pShaderBytecode, BytecodeLength);
     
+    // Stream output shaders reference semantic names owned by the
+    // application, so these have to be translated immediately.
+    // Everything else is translated on the worker threads, and
+    // the first bind will wait for the translation to finish.
+    // Byte code that fails to decode has been rejected above.
+    bool deferTranslation = pDxbcModuleInfo->xfb == nullptr;
+    
+    if (!deferTranslation && module.GetShader() == nullptr)
+      throw DxvkError(str::format("D3D11: Failed to create shader ", pShaderKey->toString()));
+    
     // Insert the new module into the lookup table. If another thread
-    // has compiled the same shader in the meantime, we should return
+    // has created the same shader in the meantime, we should return
     // that object instead and discard the newly created module.
     { std::unique_lock<std::mutex> lock(m_mutex);
       
@@ -108,6 +342,9 @@ namespace dxvk {
         return status.first->second;
     }
     
+    if (deferTranslation)
+      m_translator.QueueTranslation(module.GetTranslation());
+    
     return module;
   }
   
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
+#include <queue>
 #include <unordered_map>
+#include <vector>
 
 #include "../dxbc/dxbc_module.h"
 #include "../dxvk/dxvk_device.h"
@@ -12,6 +18,8 @@
 
 #include "../util/util_env.h"
 
+#include "../util/thread.h"
+
 #include "d3d11_device_child.h"
 #include "d3d11_interfaces.h"
 
@@ -19,12 +27,102 @@ namespace dxvk {
   
   class D3D11Device;
   
+  /**
+   * \brief Shader translation
+   * 
+   * Translates a parsed DXBC module to SPIR-V and stores
+   * the resulting shader as well as its immediate constant
+   * buffer. The DXBC module is freed once translation has
+   * finished. Translation may be executed on a worker thread,
+   * in which case accessing the shader will either wait for
+   * the translation to finish or, if it has not started yet,
+   * translate the shader on the calling thread.
+   */
+  class D3D11ShaderTranslation : public RcObject {
+    
+  public:
+    
+    D3D11ShaderTranslation(
+            D3D11Device*    pDevice,
+      const DxvkShaderKey*  pShaderKey,
+      const DxbcModuleInfo* pDxbcModuleInfo,
+      const DxbcModule&     Module,
+            size_t          BytecodeLength);
+    ~D3D11ShaderTranslation();
+    
+    /**
+     * \brief Shader key
+     * \returns Shader key
+     */
+    const DxvkShaderKey& GetKey() const {
+      return m_key;
+    }
+    
+    /**
+     * \brief Translated shader
+     * 
+     * Waits for the translation to complete.
+     * \returns The shader, or \c nullptr if
+     *    translation failed
+     */
+    Rc<DxvkShader> GetShader();
+    
+    /**
+     * \brief Immediate constant buffer
+     * 
+     * Waits for the translation to complete.
+     * \returns The constant buffer, if any
+     */
+    Rc<DxvkBuffer> GetIcb();
+    
+    /**
+     * \brief Translates the shader
+     * 
+     * Does nothing if the shader is already being
+     * translated or translation has completed.
+     */
+    void Translate();
+    
+  private:
+    
+    enum class State : uint32_t {
+      Pending   = 0,
+      Running   = 1,
+      Done      = 2,
+    };
+    
+    D3D11Device*                m_device;
+    DxvkShaderKey               m_key;
+    DxbcModuleInfo              m_moduleInfo;
+    DxbcTessInfo                m_tessInfo;
+    std::unique_ptr<DxbcModule> m_module;
+    size_t                      m_bytecodeLength;
+    
+    std::atomic<State>      m_state = { State::Pending };
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+    
+    Rc<DxvkShader> m_shader;
+    Rc<DxvkBuffer> m_buffer;
+    
+    void Wait();
+    
+    void TranslateShader();
+    
+    static Sha1Hash GetShaderCacheKey(
+      const DxvkShaderKey*  pShaderKey,
+      const DxbcModuleInfo* pDxbcModuleInfo);
+    
+  };
+  
+  
   /**
    * \brief Common shader object
    * 
-   * Stores the compiled SPIR-V shader and the SHA-1
-   * hash of the original DXBC shader, which can be
-   * used to identify the shader.
+   * References the translated SPIR-V shader, which can be
+   * identified by the SHA-1 hash of the original DXBC code.
+   * Shader objects are cheap to copy, and copies share the
+   * same translation.
    */
   class D3D11CommonShader {
     
@@ -40,21 +138,66 @@ namespace dxvk {
     ~D3D11CommonShader();
 
     Rc<DxvkShader> GetShader() const {
-      return m_shader;
+      return m_translation->GetShader();
     }
 
     Rc<DxvkBuffer> GetIcb() const {
-      return m_buffer;
+      return m_translation->GetIcb();
     }
     
     std::string GetName() const {
-      return m_shader->debugName();
+      return m_translation->GetKey().toString();
+    }
+    
+    Rc<D3D11ShaderTranslation> GetTranslation() const {
+      return m_translation;
     }
     
   private:
     
-    Rc<DxvkShader> m_shader;
-    Rc<DxvkBuffer> m_buffer;
+    Rc<D3D11ShaderTranslation> m_translation;
+    
+  };
+  
+  
+  /**
+   * \brief Shader translator
+   * 
+   * Thread pool which translates shaders in the
+   * background, so that applications which create
+   * a large number of shaders from a single thread
+   * can make use of all available CPU cores.
+   */
+  class D3D11ShaderTranslator {
+    
+  public:
+    
+    D3D11ShaderTranslator(int32_t NumThreads);
+    ~D3D11ShaderTranslator();
+    
+    /**
+     * \brief Queues a shader for translation
+     * 
+     * Starts the worker threads on first use.
+     * \param [in] pTranslation The translation
+     */
+    void QueueTranslation(
+      const Rc<D3D11ShaderTranslation>& pTranslation);
+    
+  private:
+    
+    int32_t                 m_numThreads;
+    
+    std::mutex              m_mutex;
+    std::condition_variable m_cond;
+    bool                    m_stopped = false;
+    
+    std::queue<Rc<D3D11ShaderTranslation>> m_queue;
+    std::vector<dxvk::thread>              m_workers;
+    
+    void StartWorkers();
+    
+    void WorkerFunc();
     
   };
   
@@ -130,14 +273,15 @@ namespace dxvk {
    * 
    * Some applications may compile the same shader multiple
    * times, so we should cache the resulting shader modules
-   * and reuse them rather than creating new ones. This
+   * and reuse them rather than creating new ones. Shaders
+   * are translated in the background where possible. This
    * class is thread-safe.
    */
   class D3D11ShaderModuleSet {
     
   public:
     
-    D3D11ShaderModuleSet();
+    D3D11ShaderModuleSet(int32_t NumThreads);
     ~D3D11ShaderModuleSet();
     
     D3D11CommonShader GetShaderModule(
@@ -156,6 +300,8 @@ namespace dxvk {
       D3D11CommonShader,
       DxvkHash, DxvkEq> m_modules;
     
+    D3D11ShaderTranslator m_translator;
+    
   };
   
 }
@@ -25,6 +25,17 @@ namespace dxvk {
   
   
   void DxbcAnalyzer::processInstruction(const DxbcShaderInstruction& ins) {
+    // Declarations reference registers without
+    // accessing them, so we need to ignore them
+    if (ins.opClass != DxbcInstClass::Declaration
+     && ins.opClass != DxbcInstClass::CustomData) {
+      for (uint32_t i = 0; i < ins.dstCount; i++)
+        this->processOperand(ins.dst[i], true);
+      
+      for (uint32_t i = 0; i < ins.srcCount; i++)
+        this->processOperand(ins.src[i], false);
+    }
+    
     switch (ins.opClass) {
       case DxbcInstClass::Atomic: {
         const uint32_t operandId = ins.dstCount - 1;
@@ -56,6 +67,92 @@ namespace dxvk {
   }
   
   
+  void DxbcAnalyzer::processOperand(
+    const DxbcRegister&       reg,
+          bool                write) {
+    // Registers used for relative indexing are read
+    for (uint32_t i = 0; i < reg.idxDim; i++) {
+      if (reg.idx[i].relReg != nullptr)
+        this->processOperand(*reg.idx[i].relReg, false);
+    }
+    
+    DxbcRegisterUsage* usage = nullptr;
+    
+    switch (reg.type) {
+      case DxbcOperandType::Temp: {
+        const uint32_t regId = reg.idx[0].offset;
+        
+        if (regId >= m_analysis->tempUsage.size())
+          m_analysis->tempUsage.resize(regId + 1);
+        
+        usage = &m_analysis->tempUsage[regId];
+      } break;
+      
+      case DxbcOperandType::Input: {
+        // Inputs may be indexed with a vertex index in some
+        // stages, the register index is always the last one
+        if (reg.idxDim == 0)
+          break;
+        
+        const uint32_t dim = reg.idxDim - 1;
+        
+        if (reg.idx[dim].relReg != nullptr)
+          m_analysis->inputDynamicIndex = true;
+        else if (reg.idx[dim].offset < DxbcMaxInterfaceRegs)
+          usage = &m_analysis->inputUsage[reg.idx[dim].offset];
+      } break;
+      
+      case DxbcOperandType::Output: {
+        if (reg.idx[0].relReg != nullptr)
+          m_analysis->outputDynamicIndex = true;
+        else if (reg.idx[0].offset < DxbcMaxInterfaceRegs)
+          usage = &m_analysis->outputUsage[reg.idx[0].offset];
+      } break;
+      
+      case DxbcOperandType::ConstantBuffer: {
+        const uint32_t regId = reg.idx[0].offset;
+        
+        if (regId < m_analysis->constantBufferUsage.size()) {
+          auto& cbUsage = m_analysis->constantBufferUsage[regId];
+          
+          if (reg.idx[1].relReg != nullptr) {
+            cbUsage.dynamicIndex = true;
+          } else {
+            cbUsage.numConstants = std::max<uint32_t>(
+              cbUsage.numConstants, reg.idx[1].offset + 1);
+          }
+        }
+      } break;
+      
+      default:
+        break;
+    }
+    
+    if (usage != nullptr) {
+      if (write)
+        usage->writeMask |= reg.mask;
+      else
+        usage->readMask  |= getReadMask(reg);
+    }
+  }
+  
+  
+  DxbcRegMask DxbcAnalyzer::getReadMask(
+    const DxbcRegister&       reg) {
+    // This may include components that the instruction
+    // does not actually use, which is fine since the
+    // result is only used to find unused registers.
+    DxbcRegMask mask;
+    
+    for (uint32_t i = 0; i < 4; i++) {
+      if (reg.mask[i])
+        mask |= DxbcRegMask::select(reg.swizzle[i]);
+    }
+    
+    return mask;
+  }
+  
+  
   DxbcClipCullInfo DxbcAnalyzer::getClipCullInfo(const Rc<DxbcIsgn>& sgn) const {
     DxbcClipCullInfo result;
     
@@ -29,6 +29,37 @@ namespace dxvk {
     uint32_t numCullPlanes = 0;
   };
   
+  /**
+   * \brief Register usage info
+   * 
+   * Stores which components of a register are read
+   * or written anywhere in the shader. This does not
+   * take control flow into account, so a component
+   * that is never read is dead, but not vice versa.
+   */
+  struct DxbcRegisterUsage {
+    DxbcRegMask readMask;
+    DxbcRegMask writeMask;
+    
+    bool used() const {
+      return readMask  != DxbcRegMask()
+          || writeMask != DxbcRegMask();
+    }
+  };
+  
+  /**
+   * \brief Constant buffer usage info
+   * 
+   * Stores the number of constants that are accessed
+   * with a constant index, and whether the buffer is
+   * accessed with a dynamic index. In that case, the
+   * accessed range cannot be determined.
+   */
+  struct DxbcConstantBufferUsage {
+    uint32_t numConstants   = 0;
+    bool     dynamicIndex   = false;
+  };
+  
   /**
    * \brief Shader analysis info
    */
@@ -38,6 +69,16 @@ namespace dxvk {
     DxbcClipCullInfo clipCullIn;
     DxbcClipCullInfo clipCullOut;
     
+    std::vector<DxbcRegisterUsage> tempUsage;
+    
+    std::array<DxbcRegisterUsage, DxbcMaxInterfaceRegs> inputUsage;
+    std::array<DxbcRegisterUsage, DxbcMaxInterfaceRegs> outputUsage;
+    
+    std::array<DxbcConstantBufferUsage, 16> constantBufferUsage;
+    
+    bool inputDynamicIndex  = false;
+    bool outputDynamicIndex = false;
+    
     bool usesDerivatives  = false;
     bool usesKill         = false;
   };
@@ -79,6 +120,13 @@ namespace dxvk {
     DxbcClipCullInfo getClipCullInfo(
       const Rc<DxbcIsgn>& sgn) const;
     
+    void processOperand(
+      const DxbcRegister&       reg,
+            bool                write);
+    
+    static DxbcRegMask getReadMask(
+      const DxbcRegister&       reg);
+    
   };
   
 }
@@ -15,10 +15,12 @@ namespace dxvk {
     bool hasStream    = (tag == "ISG1") || (tag == "OSG1") || (tag == "PSG1") || (tag == "OSG5");
     bool hasPrecision = (tag == "ISG1") || (tag == "OSG1") || (tag == "PSG1");
     
+    m_entries.reserve(elementCount);
+    
     for (uint32_t i = 0; i < elementCount; i++) {
       DxbcSgnEntry entry;
       entry.streamId        = hasStream ? reader.readu32() : 0;
-      entry.semanticName    = reader.clone(reader.readu32()).readString();
+      entry.semanticName    = readSemanticName(reader.clone(reader.readu32()));
       entry.semanticIndex   = reader.readu32();
       entry.systemValue     = static_cast<DxbcSystemValue>(reader.readu32());
       entry.componentType   = componentTypes.at(reader.readu32());
@@ -49,7 +51,7 @@ namespace dxvk {
   
   
   const DxbcSgnEntry* DxbcIsgn::find(
-    const std::string& semanticName,
+    const char*        semanticName,
           uint32_t     semanticIndex,
           uint32_t     streamId) const {
     for (auto e = this->begin(); e != this->end(); e++) {
@@ -77,16 +79,24 @@ namespace dxvk {
 
 
   bool DxbcIsgn::compareSemanticNames(
-    const std::string& a, const std::string& b) const {
-    if (a.size() != b.size())
-      return false;
+    const char* a, const char* b) {
+    // Interned names can be compared directly
+    if (a == b)
+      return true;
     
-    for (size_t i = 0; i < a.size(); i++) {
-      if (std::toupper(a[i]) != std::toupper(b[i]))
+    while (*a != '\0' && *b != '\0') {
+      if (std::toupper(*(a++)) != std::toupper(*(b++)))
         return false;
     }
     
-    return true;
+    return *a == *b;
+  }
+  
+  
+  const char* DxbcIsgn::readSemanticName(DxbcReader reader) {
+    size_t length = 0;
+    const char* name = reader.readStringRef(length);
+    return DxbcNameTable::intern(name, length);
   }
   
 }
\ No newline at end of file
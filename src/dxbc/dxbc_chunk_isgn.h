@@ -5,6 +5,7 @@
 #include "dxbc_common.h"
 #include "dxbc_decoder.h"
 #include "dxbc_enums.h"
+#include "dxbc_name_table.h"
 #include "dxbc_reader.h"
 
 namespace dxvk {
@@ -14,9 +15,11 @@ namespace dxvk {
    * 
    * Stores the semantic name of an input or
    * output and the corresponding register.
+   * The semantic name is interned, so that
+   * entries do not own any memory.
    */
   struct DxbcSgnEntry {
-    std::string       semanticName;
+    const char*       semanticName;
     uint32_t          semanticIndex;
     uint32_t          registerId;
     DxbcRegMask       componentMask;
@@ -45,7 +48,7 @@ namespace dxvk {
             uint32_t     registerId) const;
     
     const DxbcSgnEntry* find(
-      const std::string& semanticName,
+      const char*        semanticName,
             uint32_t     semanticIndex,
             uint32_t     streamIndex) const;
     
@@ -56,9 +59,12 @@ namespace dxvk {
     
     std::vector<DxbcSgnEntry> m_entries;
     
-    bool compareSemanticNames(
-      const std::string& a,
-      const std::string& b) const;
+    static bool compareSemanticNames(
+      const char*        a,
+      const char*        b);
+    
+    static const char* readSemanticName(
+            DxbcReader   reader);
     
   };
   
@@ -21,4 +21,14 @@ namespace dxvk {
     
   }
   
+  
+  const DxbcInstructionStream& DxbcShex::instructions() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    if (m_instructions == nullptr)
+      m_instructions = std::make_unique<DxbcInstructionStream>(this->slice());
+    
+    return *m_instructions;
+  }
+  
 }
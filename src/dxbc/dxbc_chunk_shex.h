@@ -1,5 +1,8 @@
 #pragma once
 
+#include <memory>
+#include <mutex>
+
 #include "dxbc_common.h"
 #include "dxbc_decoder.h"
 #include "dxbc_reader.h"
@@ -29,11 +32,24 @@ namespace dxvk {
         m_code.data() + m_code.size());
     }
     
+    /**
+     * \brief Decoded instructions
+     * 
+     * The code is decoded on first use, and the
+     * decoded instructions are shared by all
+     * modules that use this chunk.
+     * \returns Decoded instruction stream
+     */
+    const DxbcInstructionStream& instructions() const;
+    
   private:
     
     DxbcProgramInfo       m_programInfo;
     std::vector<uint32_t> m_code;
     
+    mutable std::mutex                             m_mutex;
+    mutable std::unique_ptr<DxbcInstructionStream> m_instructions;
+    
   };
   
 }
@@ -1,3 +1,5 @@
+#include "../spirv/spirv_optimizer.h"
+
 #include "dxbc_compiler.h"
 
 namespace dxvk {
@@ -232,6 +234,14 @@ namespace dxvk {
 
     DxvkShaderOptions shaderOptions = { };
 
+    for (uint32_t i = 0; i < m_constantBuffers.size(); i++) {
+      if (m_constantBuffers[i].pushVarId) {
+        shaderOptions.pushConstSlot = computeResourceSlotId(
+          m_programInfo.type(), DxbcBindingType::ConstantBuffer, i);
+        shaderOptions.pushConstSize = m_constantBuffers[i].size * 16;
+      }
+    }
+
     if (m_moduleInfo.xfb != nullptr) {
       shaderOptions.rasterizedStream = m_moduleInfo.xfb->rasterizedStream;
 
@@ -239,14 +249,28 @@ namespace dxvk {
         shaderOptions.xfbStrides[i] = m_moduleInfo.xfb->strides[i];
     }
 
+    // Removing unused outputs relies on the optimizer
+    // to remove the code that computes those outputs
+    shaderOptions.pruneOutputs = m_moduleInfo.options.optimizeSpirv;
+    
+    SpirvCodeBuffer code = m_module.compile();
+    
+    if (m_moduleInfo.options.optimizeSpirv) {
+      const size_t oldSize = code.size();
+      
+      if (SpirvOptimizer().optimize(code)) {
+        Logger::debug(str::format("DxbcCompiler: Optimized shader: ",
+          oldSize, " -> ", code.size(), " bytes"));
+      }
+    }
+    
     // Create the shader module object
     return new DxvkShader(
       m_programInfo.shaderStage(),
       m_resourceSlots.size(),
       m_resourceSlots.data(),
       m_interfaceSlots,
-      m_module.compile(),
-      shaderOptions,
+      code, shaderOptions,
       std::move(m_immConstData));
   }
   
@@ -364,6 +388,12 @@ namespace dxvk {
       info.sclass       = spv::StorageClassPrivate;
       
       for (uint32_t i = oldCount; i < newCount; i++) {
+        // Registers that are never accessed do not need
+        // a variable, since no instruction can use them
+        if (i >= m_analysis->tempUsage.size()
+         || !m_analysis->tempUsage[i].used())
+          continue;
+        
         const uint32_t varId = this->emitNewVariable(info);
         m_module.setDebugName(varId, str::format("r", i).c_str());
         m_rRegs.at(i) = varId;
@@ -631,6 +661,15 @@ namespace dxvk {
     // This may happen when multiple system values are
     // mapped to different parts of the same register.
     if (m_vRegs.at(regIdx).id == 0 && sv == DxbcSystemValue::None) {
+      // Inputs that are never read can be dropped. Sample rate
+      // shading must still be enabled if the input requests it.
+      if (!isInputRegUsed(regIdx)) {
+        if (im == DxbcInterpolationMode::LinearSample
+         || im == DxbcInterpolationMode::LinearNoPerspectiveSample)
+          m_module.enableCapability(spv::CapabilitySampleRateShading);
+        return;
+      }
+      
       const DxbcVectorType regType = getInputRegType(regIdx);
       
       DxbcRegisterInfo info;
@@ -694,8 +733,12 @@ namespace dxvk {
     
     if (m_programInfo.type() == DxbcProgramType::HullShader) {
       // Hull shaders don't use standard outputs
-      if (getCurrentHsForkJoinPhase() != nullptr)
+      auto phase = getCurrentHsForkJoinPhase();
+      
+      if (phase != nullptr) {
         m_hs.outputPerPatchMask |= 1 << regIdx;
+        phase->outputs.push_back({ regIdx, regMask, sv });
+      }
     } else if (m_oRegs.at(regIdx).id == 0) {
       // Avoid declaring the same variable multiple times.
       // This may happen when multiple system values are
@@ -738,10 +781,59 @@ namespace dxvk {
     //    (0) Constant buffer register ID (cb#)
     //    (1) Number of constants in the buffer
     const uint32_t bufferId     = ins.dst[0].idx[0].offset;
-    const uint32_t elementCount = ins.dst[0].idx[1].offset;
+          uint32_t elementCount = ins.dst[0].idx[1].offset;
+    
+    // If the buffer is only accessed with constant indices,
+    // we can declare it with the size that is actually used
+    const DxbcConstantBufferUsage& usage = m_analysis->constantBufferUsage.at(bufferId);
+    
+    if (!usage.dynamicIndex) {
+      elementCount = std::min(elementCount,
+        std::max(usage.numConstants, 1u));
+    }
     
     this->emitDclConstantBufferVar(bufferId, elementCount,
       str::format("cb", bufferId).c_str());
+    
+    // Small constant buffers can additionally be read from
+    // push constant memory. Only one buffer per shader is
+    // supported since the push constant space is tiny.
+    bool hasPushConstants = false;
+
+    for (const auto& cb : m_constantBuffers)
+      hasPushConstants |= cb.pushVarId != 0;
+    
+    if (m_moduleInfo.options.usePushConstants && !hasPushConstants
+     && !usage.dynamicIndex && elementCount * 16 <= MaxPushConstantSize)
+      this->emitDclConstantBufferPush(bufferId, elementCount);
+  }
+  
+  
+  void DxbcCompiler::emitDclConstantBufferPush(
+          uint32_t                regIdx,
+          uint32_t                numConstants) {
+    // Use the same layout as the uniform buffer so
+    // that the data can be pushed without repacking
+    const uint32_t arrayType = m_module.defArrayTypeUnique(
+      getVectorTypeId({ DxbcScalarType::Float32, 4 }),
+      m_module.constu32(numConstants));
+    m_module.decorateArrayStride(arrayType, 16);
+    
+    const uint32_t structType = m_module.defStructTypeUnique(1, &arrayType);
+    
+    m_module.decorateBlock       (structType);
+    m_module.memberDecorateOffset(structType, 0, 0);
+    
+    m_module.setDebugName        (structType, str::format("cb", regIdx, "_push_t").c_str());
+    m_module.setDebugMemberName  (structType, 0, "m");
+    
+    const uint32_t varId = m_module.newVar(
+      m_module.defPointerType(structType, spv::StorageClassPushConstant),
+      spv::StorageClassPushConstant);
+    
+    m_module.setDebugName(varId, str::format("cb", regIdx, "_push").c_str());
+    
+    m_constantBuffers.at(regIdx).pushVarId = varId;
   }
   
   
@@ -974,6 +1066,7 @@ namespace dxvk {
       uav.imageInfo     = typeInfo;
       uav.varId         = varId;
       uav.ctrId         = 0;
+      uav.ctrSpecId     = 0;
       uav.specId        = specConstId;
       uav.sampledType   = sampledType;
       uav.sampledTypeId = sampledTypeId;
@@ -1121,6 +1214,7 @@ namespace dxvk {
       uav.imageInfo     = typeInfo;
       uav.varId         = varId;
       uav.ctrId         = 0;
+      uav.ctrSpecId     = 0;
       uav.specId        = specConstId;
       uav.sampledType   = sampledType;
       uav.sampledTypeId = sampledTypeId;
@@ -1356,7 +1450,7 @@ namespace dxvk {
   }
   
   
-  uint32_t DxbcCompiler::emitDclUavCounter(uint32_t regId) {
+  void DxbcCompiler::emitDclUavCounter(uint32_t regId) {
     // Declare a structure type which holds the UAV counter
     if (m_uavCtrStructType == 0) {
       const uint32_t t_u32    = m_module.defIntType(32, 0);
@@ -1387,6 +1481,14 @@ namespace dxvk {
     m_module.decorateDescriptorSet(varId, 0);
     m_module.decorateBinding(varId, bindingId);
     
+    // Declare a specialization constant which will store
+    // whether or not a counter buffer is bound, so that
+    // counter operations can be folded away if not.
+    const uint32_t specConstId = m_module.specConstBool(true);
+    m_module.decorateSpecId(specConstId, bindingId);
+    m_module.setDebugName(specConstId,
+      str::format("u", regId, "_meta_bound").c_str());
+    
     // Declare the storage buffer binding
     DxvkResourceSlot resource;
     resource.slot = bindingId;
@@ -1396,7 +1498,8 @@ namespace dxvk {
                     | VK_ACCESS_SHADER_WRITE_BIT;
     m_resourceSlots.push_back(resource);
     
-    return varId;
+    m_uavs.at(regId).ctrId     = varId;
+    m_uavs.at(regId).ctrSpecId = specConstId;
   }
   
   
@@ -2190,6 +2293,10 @@ namespace dxvk {
     const bool isImm = ins.dstCount == 2;
     const bool isUav = ins.dst[ins.dstCount - 1].type == DxbcOperandType::UnorderedAccessView;
     
+    // Compute the address within the resource
+    const DxbcRegisterValue address = emitLoadAtomicAddress(
+      ins.dst[ins.dstCount - 1], ins.src[0]);
+    
     // Perform atomic operations on UAVs only if the UAV
     // is bound and if there is nothing else stopping us.
     DxbcConditional cond;
@@ -2197,6 +2304,19 @@ namespace dxvk {
     if (isUav) {
       uint32_t writeTest = emitUavWriteTest(bufferInfo);
       
+      // Discard out-of-bounds atomics on buffers. Raw
+      // and structured buffers may be bound as SSBOs.
+      if (m_moduleInfo.options.useBufferBoundsChecks
+       && bufferInfo.image.dim == spv::DimBuffer) {
+        bool isSsbo = m_moduleInfo.options.useRawSsbo
+                   && bufferInfo.type != DxbcResourceType::Typed;
+        
+        writeTest = m_module.opLogicalAnd(
+          m_module.defBoolType(), writeTest,
+          emitBufferBoundsTest(address,
+            emitQueryBufferElementCount(bufferInfo, isSsbo)));
+      }
+      
       cond.labelIf  = m_module.allocateId();
       cond.labelEnd = m_module.allocateId();
       
@@ -2208,7 +2328,7 @@ namespace dxvk {
     
     // Retrieve destination pointer for the atomic operation>
     const DxbcRegisterPointer pointer = emitGetAtomicPointer(
-      ins.dst[ins.dstCount - 1], ins.src[0]);
+      ins.dst[ins.dstCount - 1], address);
     
     // Load source values
     std::array<DxbcRegisterValue, 2> src;
@@ -2344,10 +2464,13 @@ namespace dxvk {
     const uint32_t registerId = ins.dst[1].idx[0].offset;
     
     if (m_uavs.at(registerId).ctrId == 0)
-      m_uavs.at(registerId).ctrId = emitDclUavCounter(registerId);
+      emitDclUavCounter(registerId);
     
-    // Only perform the operation if the UAV is bound
-    uint32_t writeTest = emitUavWriteTest(bufferInfo);
+    // Only perform the operation if both the UAV
+    // and the counter buffer are bound
+    uint32_t writeTest = m_module.opLogicalAnd(
+      m_module.defBoolType(), emitUavWriteTest(bufferInfo),
+      m_uavs.at(registerId).ctrSpecId);
     
     DxbcConditional cond;
     cond.labelIf  = m_module.allocateId();
@@ -2386,17 +2509,54 @@ namespace dxvk {
     
     const uint32_t typeId = getVectorTypeId(value.type);
     
+    // In compute shaders, one invocation can update the counter
+    // for the entire subgroup. Each invocation then computes its
+    // own counter value from the number of active invocations
+    // with a lower invocation index.
+    const bool useSubgroupOps = m_moduleInfo.options.useSubgroupOpsForAtomicCounters
+      && m_programInfo.type() == DxbcProgramType::ComputeShader;
+    
+    uint32_t delta = m_module.constu32(1);
+    uint32_t laneOffset = 0;
+    
+    DxbcConditional elect;
+    
+    if (useSubgroupOps) {
+      m_module.enableCapability(spv::CapabilityGroupNonUniform);
+      m_module.enableCapability(spv::CapabilityGroupNonUniformBallot);
+      
+      const uint32_t subgroupScopeId = m_module.constu32(spv::ScopeSubgroup);
+      
+      const uint32_t ballot = m_module.opGroupNonUniformBallot(
+        getVectorTypeId({ DxbcScalarType::Uint32, 4 }),
+        subgroupScopeId, m_module.constBool(true));
+      
+      delta = m_module.opGroupNonUniformBallotBitCount(
+        typeId, subgroupScopeId, spv::GroupOperationReduce, ballot);
+      
+      laneOffset = m_module.opGroupNonUniformBallotBitCount(
+        typeId, subgroupScopeId, spv::GroupOperationExclusiveScan, ballot);
+      
+      elect.labelIf  = m_module.allocateId();
+      elect.labelEnd = m_module.allocateId();
+      
+      m_module.opSelectionMerge(elect.labelEnd, spv::SelectionControlMaskNone);
+      m_module.opBranchConditional(
+        m_module.opGroupNonUniformElect(m_module.defBoolType(), subgroupScopeId),
+        elect.labelIf, elect.labelEnd);
+      
+      m_module.opLabel(elect.labelIf);
+    }
+    
     switch (ins.op) {
       case DxbcOpcode::ImmAtomicAlloc:
         value.id = m_module.opAtomicIAdd(typeId, ptrId,
-          scopeId, semanticsId, m_module.constu32(1));
+          scopeId, semanticsId, delta);
         break;
         
       case DxbcOpcode::ImmAtomicConsume:
         value.id = m_module.opAtomicISub(typeId, ptrId,
-          scopeId, semanticsId, m_module.constu32(1));
-        value.id = m_module.opISub(typeId, value.id,
-          m_module.constu32(1));
+          scopeId, semanticsId, delta);
         break;
       
       default:
@@ -2406,6 +2566,38 @@ namespace dxvk {
         return;
     }
     
+    if (useSubgroupOps) {
+      m_module.opBranch(elect.labelEnd);
+      m_module.opLabel (elect.labelEnd);
+      
+      // The counter value is only defined for the elected
+      // invocation, which is the lowest active invocation
+      const std::array<SpirvPhiLabel, 2> phiLabels = {{
+        { value.id,                elect.labelIf  },
+        { m_module.constu32(0),    cond.labelIf   },
+      }};
+      
+      value.id = m_module.opPhi(typeId,
+        phiLabels.size(), phiLabels.data());
+      
+      value.id = m_module.opGroupNonUniformBroadcastFirst(typeId,
+        m_module.constu32(spv::ScopeSubgroup), value.id);
+    }
+    
+    // Consume returns the new counter value rather than the old
+    // one. With subgroup ops, each invocation needs to apply its
+    // own offset to the value returned to the elected invocation.
+    if (ins.op == DxbcOpcode::ImmAtomicAlloc) {
+      if (useSubgroupOps)
+        value.id = m_module.opIAdd(typeId, value.id, laneOffset);
+    } else {
+      if (useSubgroupOps)
+        value.id = m_module.opISub(typeId, value.id, laneOffset);
+      
+      value.id = m_module.opISub(typeId, value.id,
+        m_module.constu32(1));
+    }
+    
     // Store the result
     emitRegisterStore(ins.dst[0], value);
     
@@ -3179,7 +3371,7 @@ namespace dxvk {
     }
     
     // Extract coordinates from address
-    const DxbcRegisterValue coord = emitCalcTexCoord(address, imageType);
+    DxbcRegisterValue coord = emitCalcTexCoord(address, imageType);
     
     // Fetch texels only if the resource is actually bound
     const uint32_t labelMerge     = m_module.allocateId();
@@ -3196,6 +3388,18 @@ namespace dxvk {
       m_textures.at(textureId).imageTypeId,
       m_textures.at(textureId).varId);
     
+    // Out-of-bounds reads from typed buffers return zero
+    bool useBoundsCheck = m_moduleInfo.options.useBufferBoundsChecks
+                       && imageType.dim == spv::DimBuffer;
+    
+    uint32_t inBounds = 0;
+    
+    if (useBoundsCheck) {
+      inBounds = emitBufferBoundsTest(coord,
+        emitQueryBufferElementCount(getBufferInfo(ins.src[1]), false));
+      coord = emitBufferBoundsClamp(coord, inBounds);
+    }
+    
     DxbcRegisterValue result;
     result.type.ctype  = m_textures.at(textureId).sampledType;
     result.type.ccount = 4;
@@ -3203,6 +3407,9 @@ namespace dxvk {
       getVectorTypeId(result.type), imageId,
       coord.id, imageOperands);
     
+    if (useBoundsCheck)
+      result = emitBufferBoundsResult(result, inBounds);
+    
     // Swizzle components using the texture swizzle
     // and the destination operand's write mask
     result = emitRegisterSwizzle(result,
@@ -3523,6 +3730,18 @@ namespace dxvk {
     DxbcRegisterValue texCoord = emitLoadTexCoord(
       ins.src[0], uavInfo.imageInfo);
     
+    // Out-of-bounds reads from typed buffers return zero
+    bool useBoundsCheck = m_moduleInfo.options.useBufferBoundsChecks
+                       && uavInfo.imageInfo.dim == spv::DimBuffer;
+    
+    uint32_t inBounds = 0;
+    
+    if (useBoundsCheck) {
+      inBounds = emitBufferBoundsTest(texCoord,
+        emitQueryBufferElementCount(getBufferInfo(ins.src[1]), false));
+      texCoord = emitBufferBoundsClamp(texCoord, inBounds);
+    }
+    
     // Load source value from the UAV
     DxbcRegisterValue uavValue;
     uavValue.type.ctype  = uavInfo.sampledType;
@@ -3532,6 +3751,9 @@ namespace dxvk {
       m_module.opLoad(uavInfo.imageTypeId, uavInfo.varId),
       texCoord.id, SpirvImageOperands());
     
+    if (useBoundsCheck)
+      uavValue = emitBufferBoundsResult(uavValue, inBounds);
+    
     // Apply component swizzle and mask
     uavValue = emitRegisterSwizzle(uavValue,
       ins.src[1].swizzle, ins.dst[0].mask);
@@ -3547,9 +3769,21 @@ namespace dxvk {
     //    (src1) The value to store
     const DxbcBufferInfo uavInfo = getBufferInfo(ins.dst[0]);
     
-    // Execute write op only if the UAV is bound
+    // Load texture coordinates
+    DxbcRegisterValue texCoord = emitLoadTexCoord(ins.src[0], uavInfo.image);
+    
+    // Execute write op only if the UAV is bound, and
+    // discard out-of-bounds writes to typed buffers
     uint32_t writeTest = emitUavWriteTest(uavInfo);
     
+    if (m_moduleInfo.options.useBufferBoundsChecks
+     && uavInfo.image.dim == spv::DimBuffer) {
+      writeTest = m_module.opLogicalAnd(
+        m_module.defBoolType(), writeTest,
+        emitBufferBoundsTest(texCoord,
+          emitQueryBufferElementCount(uavInfo, false)));
+    }
+    
     DxbcConditional cond;
     cond.labelIf  = m_module.allocateId();
     cond.labelEnd = m_module.allocateId();
@@ -3559,9 +3793,6 @@ namespace dxvk {
     
     m_module.opLabel(cond.labelIf);
     
-    // Load texture coordinates
-    DxbcRegisterValue texCoord = emitLoadTexCoord(ins.src[0], uavInfo.image);
-    
     // Load the value that will be written to the image. We'll
     // have to cast it to the component type of the image.
     const DxbcRegisterValue texValue = emitRegisterBitcast(
@@ -4739,9 +4970,8 @@ namespace dxvk {
   
   DxbcRegisterPointer DxbcCompiler::emitGetAtomicPointer(
     const DxbcRegister&           operand,
-    const DxbcRegister&           address) {
+    const DxbcRegisterValue&      address) {
     // Query information about the resource itself
-    const uint32_t registerId = operand.idx[0].offset;
     const DxbcBufferInfo resourceInfo = getBufferInfo(operand);
     
     // For UAVs and shared memory, different methods
@@ -4751,36 +4981,6 @@ namespace dxvk {
                && resourceInfo.type != DxbcResourceType::Typed
                && !isTgsm;
     
-    // Compute the actual address into the resource
-    const DxbcRegisterValue addressValue = [&] {
-      switch (resourceInfo.type) {
-        case DxbcResourceType::Raw:
-          return emitCalcBufferIndexRaw(emitRegisterLoad(
-            address, DxbcRegMask(true, false, false, false)));
-          
-        case DxbcResourceType::Structured: {
-          const DxbcRegisterValue addressComponents = emitRegisterLoad(
-            address, DxbcRegMask(true, true, false, false));
-          
-          return emitCalcBufferIndexStructured(
-            emitRegisterExtract(addressComponents, DxbcRegMask(true, false, false, false)),
-            emitRegisterExtract(addressComponents, DxbcRegMask(false, true, false, false)),
-            resourceInfo.stride);
-        };
-        
-        case DxbcResourceType::Typed: {
-          if (isTgsm)
-            throw DxvkError("DxbcCompiler: TGSM cannot be typed");
-          
-          return emitLoadTexCoord(address,
-            m_uavs.at(registerId).imageInfo);
-        }
-        
-        default:
-          throw DxvkError("DxbcCompiler: Unhandled resource type");
-      }
-    }();
-    
     // Compute the actual pointer
     DxbcRegisterPointer result;
     result.type.ctype  = resourceInfo.stype;
@@ -4788,15 +4988,15 @@ namespace dxvk {
 
     if (isTgsm) {
       result.id = m_module.opAccessChain(resourceInfo.typeId,
-        resourceInfo.varId, 1, &addressValue.id);
+        resourceInfo.varId, 1, &address.id);
     } else if (isSsbo) {
-      uint32_t indices[2] = { m_module.constu32(0), addressValue.id };
+      uint32_t indices[2] = { m_module.constu32(0), address.id };
       result.id = m_module.opAccessChain(resourceInfo.typeId,
         resourceInfo.varId, 2, indices);
     } else {
       result.id = m_module.opImageTexelPointer(
         m_module.defPointerType(getVectorTypeId(result.type), spv::StorageClassImage),
-        resourceInfo.varId, addressValue.id, m_module.constu32(0));
+        resourceInfo.varId, address.id, m_module.constu32(0));
     }
 
     return result;
@@ -4820,6 +5020,14 @@ namespace dxvk {
     uint32_t vectorTypeId = getVectorTypeId({ DxbcScalarType::Uint32, 4 });
     uint32_t scalarTypeId = getVectorTypeId({ DxbcScalarType::Uint32, 1 });
     
+    // Without robust buffer access, out-of-bounds
+    // reads have to return zero explicitly
+    bool useBoundsCheck = m_moduleInfo.options.useBufferBoundsChecks && !isTgsm;
+    
+    uint32_t elementCount = useBoundsCheck
+      ? emitQueryBufferElementCount(bufferInfo, isSsbo)
+      : 0;
+    
     // Since all data is represented as a sequence of 32-bit
     // integers, we have to load each component individually.
     std::array<uint32_t, 4> ccomps = { 0, 0, 0, 0 };
@@ -4833,35 +5041,51 @@ namespace dxvk {
         continue;
       
       if (ccomps[sindex] == 0) {
-        uint32_t elementIndexAdjusted = m_module.opIAdd(
+        DxbcRegisterValue elementIndexAdjusted = elementIndex;
+        elementIndexAdjusted.id = m_module.opIAdd(
           getVectorTypeId(elementIndex.type), elementIndex.id,
           m_module.consti32(sindex));
         
+        uint32_t inBounds = 0;
+        
+        if (useBoundsCheck) {
+          inBounds = emitBufferBoundsTest(elementIndexAdjusted, elementCount);
+          elementIndexAdjusted = emitBufferBoundsClamp(elementIndexAdjusted, inBounds);
+        }
+        
         // Load requested component from the buffer
         uint32_t zero = 0;
 
         if (isTgsm) {
           ccomps[sindex] = m_module.opLoad(scalarTypeId,
             m_module.opAccessChain(bufferInfo.typeId,
-              bufferInfo.varId, 1, &elementIndexAdjusted));
+              bufferInfo.varId, 1, &elementIndexAdjusted.id));
         } else if (isSsbo) {
-          uint32_t indices[2] = { m_module.constu32(0), elementIndexAdjusted };
+          uint32_t indices[2] = { m_module.constu32(0), elementIndexAdjusted.id };
           ccomps[sindex] = m_module.opLoad(scalarTypeId,
             m_module.opAccessChain(bufferInfo.typeId,
               bufferInfo.varId, 2, indices));
         } else if (operand.type == DxbcOperandType::Resource) {
           ccomps[sindex] = m_module.opCompositeExtract(scalarTypeId,
             m_module.opImageFetch(vectorTypeId,
-              bufferId, elementIndexAdjusted,
+              bufferId, elementIndexAdjusted.id,
               SpirvImageOperands()), 1, &zero);
         } else if (operand.type == DxbcOperandType::UnorderedAccessView) {
           ccomps[sindex] = m_module.opCompositeExtract(scalarTypeId,
             m_module.opImageRead(vectorTypeId,
-              bufferId, elementIndexAdjusted,
+              bufferId, elementIndexAdjusted.id,
               SpirvImageOperands()), 1, &zero);
         } else {
           throw DxvkError("DxbcCompiler: Invalid operand type for strucured/raw load");
         }
+        
+        if (useBoundsCheck) {
+          DxbcRegisterValue component;
+          component.type = { DxbcScalarType::Uint32, 1 };
+          component.id   = ccomps[sindex];
+          
+          ccomps[sindex] = emitBufferBoundsResult(component, inBounds).id;
+        }
       }
     }
 
@@ -4922,6 +5146,14 @@ namespace dxvk {
     uint32_t scalarTypeId = getVectorTypeId({ DxbcScalarType::Uint32, 1 });
     uint32_t vectorTypeId = getVectorTypeId({ DxbcScalarType::Uint32, 4 });
     
+    // Without robust buffer access, out-of-bounds
+    // writes have to be discarded explicitly
+    bool useBoundsCheck = m_moduleInfo.options.useBufferBoundsChecks && !isTgsm;
+    
+    uint32_t elementCount = useBoundsCheck
+      ? emitQueryBufferElementCount(bufferInfo, isSsbo)
+      : 0;
+    
     uint32_t srcComponentIndex = 0;
     
     for (uint32_t i = 0; i < 4; i++) {
@@ -4937,6 +5169,24 @@ namespace dxvk {
               elementIndex.id, m_module.consti32(i))
           : elementIndex.id;
         
+        DxbcConditional bounds;
+        
+        if (useBoundsCheck) {
+          DxbcRegisterValue index;
+          index.type = elementIndex.type;
+          index.id   = elementIndexAdjusted;
+          
+          uint32_t inBounds = emitBufferBoundsTest(index, elementCount);
+          
+          bounds.labelIf  = m_module.allocateId();
+          bounds.labelEnd = m_module.allocateId();
+          
+          m_module.opSelectionMerge(bounds.labelEnd, spv::SelectionControlMaskNone);
+          m_module.opBranchConditional(inBounds, bounds.labelIf, bounds.labelEnd);
+          
+          m_module.opLabel(bounds.labelIf);
+        }
+        
         if (isTgsm) {
           m_module.opStore(
             m_module.opAccessChain(bufferInfo.typeId,
@@ -4963,6 +5213,11 @@ namespace dxvk {
           throw DxvkError("DxbcCompiler: Invalid operand type for strucured/raw store");
         }
         
+        if (useBoundsCheck) {
+          m_module.opBranch(bounds.labelEnd);
+          m_module.opLabel (bounds.labelEnd);
+        }
+        
         // Write next component
         srcComponentIndex += 1;
       }
@@ -5125,6 +5380,39 @@ namespace dxvk {
   }
   
   
+  DxbcRegisterValue DxbcCompiler::emitLoadAtomicAddress(
+    const DxbcRegister&           operand,
+    const DxbcRegister&           address) {
+    const DxbcBufferInfo resourceInfo = getBufferInfo(operand);
+    
+    switch (resourceInfo.type) {
+      case DxbcResourceType::Raw:
+        return emitCalcBufferIndexRaw(emitRegisterLoad(
+          address, DxbcRegMask(true, false, false, false)));
+        
+      case DxbcResourceType::Structured: {
+        const DxbcRegisterValue addressComponents = emitRegisterLoad(
+          address, DxbcRegMask(true, true, false, false));
+        
+        return emitCalcBufferIndexStructured(
+          emitRegisterExtract(addressComponents, DxbcRegMask(true, false, false, false)),
+          emitRegisterExtract(addressComponents, DxbcRegMask(false, true, false, false)),
+          resourceInfo.stride);
+      };
+      
+      case DxbcResourceType::Typed: {
+        if (operand.type == DxbcOperandType::ThreadGroupSharedMemory)
+          throw DxvkError("DxbcCompiler: TGSM cannot be typed");
+        
+        return emitLoadTexCoord(address, resourceInfo.image);
+      }
+      
+      default:
+        throw DxvkError("DxbcCompiler: Unhandled resource type");
+    }
+  }
+  
+  
   DxbcRegisterValue DxbcCompiler::emitIndexLoad(
           DxbcRegIndex            index) {
     if (index.relReg != nullptr) {
@@ -5189,10 +5477,82 @@ namespace dxvk {
   
   DxbcRegisterValue DxbcCompiler::emitRegisterLoadRaw(
     const DxbcRegister&           reg) {
+    if (reg.type == DxbcOperandType::ConstantBuffer
+     && m_constantBuffers.at(reg.idx[0].offset).pushVarId)
+      return emitConstBufLoad(reg);
+    
     return emitValueLoad(emitGetOperandPtr(reg));
   }
   
   
+  DxbcRegisterValue DxbcCompiler::emitConstBufLoad(
+    const DxbcRegister&           reg) {
+    const DxbcConstantBuffer& cb = m_constantBuffers.at(reg.idx[0].offset);
+    
+    // The push data is only valid if this stage owns the push
+    // constant range of the pipeline and if the buffer contents
+    // were available on the host, which the binding state
+    // indicates. Both are known when the pipeline is compiled,
+    // so the driver can remove the branch that is not taken.
+    const uint32_t boolType = m_module.defBoolType();
+    
+    uint32_t cond = m_module.opLogicalAnd(boolType, cb.specId,
+      m_module.opIEqual(boolType,
+        getSpecConstant(DxvkSpecConstantId::PushConstantStage).id,
+        m_module.constu32(uint32_t(m_programInfo.shaderStage()))));
+    
+    const uint32_t labelMerge = m_module.allocateId();
+    const uint32_t labelPush  = m_module.allocateId();
+    const uint32_t labelUbo   = m_module.allocateId();
+    
+    m_module.opSelectionMerge(labelMerge, spv::SelectionControlMaskNone);
+    m_module.opBranchConditional(cond, labelPush, labelUbo);
+    
+    // Load the constant from push constant memory
+    m_module.opLabel(labelPush);
+    
+    DxbcRegisterInfo info;
+    info.type.ctype   = DxbcScalarType::Float32;
+    info.type.ccount  = 4;
+    info.type.alength = 0;
+    info.sclass = spv::StorageClassPushConstant;
+    
+    const std::array<uint32_t, 2> indices =
+      {{ m_module.consti32(0), emitIndexLoad(reg.idx[1]).id }};
+    
+    DxbcRegisterPointer pushPtr;
+    pushPtr.type.ctype  = info.type.ctype;
+    pushPtr.type.ccount = info.type.ccount;
+    pushPtr.id = m_module.opAccessChain(
+      getPointerTypeId(info), cb.pushVarId,
+      indices.size(), indices.data());
+    
+    DxbcRegisterValue pushValue = emitValueLoad(pushPtr);
+    m_module.opBranch(labelMerge);
+    
+    // Load the constant from the uniform buffer
+    m_module.opLabel(labelUbo);
+    
+    DxbcRegisterValue uboValue = emitValueLoad(emitGetConstBufPtr(reg));
+    m_module.opBranch(labelMerge);
+    
+    // Merge the result with a phi function
+    m_module.opLabel(labelMerge);
+    
+    const std::array<SpirvPhiLabel, 2> phiLabels = {{
+      { pushValue.id, labelPush },
+      { uboValue.id,  labelUbo  },
+    }};
+    
+    DxbcRegisterValue result;
+    result.type = uboValue.type;
+    result.id = m_module.opPhi(
+      getVectorTypeId(result.type),
+      phiLabels.size(), phiLabels.data());
+    return result;
+  }
+  
+  
   DxbcRegisterValue DxbcCompiler::emitRegisterLoad(
     const DxbcRegister&           reg,
           DxbcRegMask             writeMask) {
@@ -5290,6 +5650,7 @@ namespace dxvk {
       uint32_t(DxvkSpecConstantId::SpecConstantIdMax) -
       uint32_t(DxvkSpecConstantId::SpecConstantIdMin) + 1> s_specConstants = {{
         { DxbcScalarType::Uint32,   1,   1, "RasterizerSampleCount" },
+        { DxbcScalarType::Uint32,   1,   0, "PushConstantStage"     },
     }};
     
     return s_specConstants.at(uint32_t(specId) - uint32_t(DxvkSpecConstantId::SpecConstantIdMin));
@@ -5441,6 +5802,11 @@ namespace dxvk {
       if (m_oRegs[i].id == 0 || m_oRegs[i].type.ccount < 2)
         continue;
       
+      // Outputs that are never written are undefined anyway
+      if (!m_analysis->outputDynamicIndex
+       && m_analysis->outputUsage[i].writeMask == DxbcRegMask())
+        continue;
+      
       DxbcRegisterValue vector = emitValueLoad(m_oRegs[i]);
 
       uint32_t specTypeId = getScalarTypeId(DxbcScalarType::Uint32);
@@ -6134,6 +6500,80 @@ namespace dxvk {
   }
   
   
+  uint32_t DxbcCompiler::emitQueryBufferElementCount(
+    const DxbcBufferInfo&         buffer,
+          bool                    isSsbo) {
+    // Raw and structured SSBOs are arrays of 32-bit words,
+    // and buffer views are indexed by texels. In both cases
+    // the size matches the indices used to access the buffer.
+    const uint32_t typeId = getScalarTypeId(DxbcScalarType::Uint32);
+    
+    if (isSsbo)
+      return m_module.opArrayLength(typeId, buffer.varId, 0);
+    
+    return m_module.opImageQuerySize(typeId,
+      m_module.opLoad(buffer.typeId, buffer.varId));
+  }
+  
+  
+  uint32_t DxbcCompiler::emitBufferBoundsTest(
+          DxbcRegisterValue       index,
+          uint32_t                elementCount) {
+    // Negative indices are out of bounds as well
+    return m_module.opULessThan(
+      m_module.defBoolType(),
+      index.id, elementCount);
+  }
+  
+  
+  DxbcRegisterValue DxbcCompiler::emitBufferBoundsClamp(
+          DxbcRegisterValue       index,
+          uint32_t                inBounds) {
+    // Redirect out-of-bounds accesses to the first element,
+    // which is valid for all buffers that are not empty.
+    const uint32_t zero = index.type.ctype == DxbcScalarType::Sint32
+      ? m_module.consti32(0)
+      : m_module.constu32(0);
+    
+    index.id = m_module.opSelect(
+      getVectorTypeId(index.type),
+      inBounds, index.id, zero);
+    return index;
+  }
+  
+  
+  DxbcRegisterValue DxbcCompiler::emitBufferBoundsResult(
+          DxbcRegisterValue       value,
+          uint32_t                inBounds) {
+    const DxbcRegMask mask = DxbcRegMask::firstN(value.type.ccount);
+    
+    const DxbcRegisterValue zero = [&] {
+      switch (value.type.ctype) {
+        case DxbcScalarType::Float32: return emitBuildConstVecf32(0.0f, 0.0f, 0.0f, 0.0f, mask);
+        case DxbcScalarType::Uint32:  return emitBuildConstVecu32(0u, 0u, 0u, 0u,         mask);
+        case DxbcScalarType::Sint32:  return emitBuildConstVeci32(0, 0, 0, 0,             mask);
+        default: throw DxvkError("DxbcCompiler: Invalid scalar type");
+      }
+    }();
+    
+    // OpSelect requires a boolean vector for vector operands
+    uint32_t cond = inBounds;
+    
+    if (value.type.ccount > 1) {
+      const std::array<uint32_t, 4> condVec = {{ inBounds, inBounds, inBounds, inBounds }};
+      
+      cond = m_module.opCompositeConstruct(
+        m_module.defVectorType(m_module.defBoolType(), value.type.ccount),
+        value.type.ccount, condVec.data());
+    }
+    
+    value.id = m_module.opSelect(
+      getVectorTypeId(value.type),
+      cond, value.id, zero.id);
+    return value;
+  }
+  
+  
   void DxbcCompiler::emitInit() {
     // Set up common capabilities for all shaders
     m_module.enableCapability(spv::CapabilityShader);
@@ -6446,8 +6886,15 @@ namespace dxvk {
     this->emitHsControlPointPhase(m_hs.cpPhase);
     this->emitHsPhaseBarrier();
     
+    if (m_moduleInfo.options.parallelizeHsForkPhases
+     && this->canRunHsForkPhasesInParallel()) {
+      this->emitHsForkPhasesParallel();
+      this->emitFunctionEnd();
+      return;
+    }
+    
     // Fork-join phases and output setup
-    this->emitHsInvocationBlockBegin(1);
+    this->emitHsInvocationBlockBegin(0);
     
     for (const auto& phase : m_hs.forkPhases)
       this->emitHsForkJoinPhase(phase);
@@ -6815,14 +7262,14 @@ namespace dxvk {
   }
   
   
-  void DxbcCompiler::emitHsInvocationBlockBegin(uint32_t count) {
+  void DxbcCompiler::emitHsInvocationBlockBegin(uint32_t invocation) {
     uint32_t invocationId = m_module.opLoad(
       getScalarTypeId(DxbcScalarType::Uint32),
       m_hs.builtinInvocationId);
     
-    uint32_t condition = m_module.opULessThan(
+    uint32_t condition = m_module.opIEqual(
       m_module.defBoolType(), invocationId,
-      m_module.constu32(count));
+      m_module.constu32(invocation));
     
     m_hs.invocationBlockBegin = m_module.allocateId();
     m_hs.invocationBlockEnd   = m_module.allocateId();
@@ -6871,6 +7318,98 @@ namespace dxvk {
   }
   
   
+  void DxbcCompiler::emitHsForkPhasesParallel() {
+    // Fork phases are independent of each other, so instead of
+    // running all of them in the first invocation, distribute
+    // them across all invocations of the patch. Each invocation
+    // writes the patch constants produced by its own phases.
+    uint32_t phaseCount      = m_hs.forkPhases.size();
+    uint32_t invocationCount = std::min(m_hs.vertexCountOut, phaseCount);
+    
+    uint32_t outputPerPatch = emitTessInterfacePerPatch(spv::StorageClassOutput);
+    
+    for (uint32_t i = 0; i < invocationCount; i++) {
+      this->emitHsInvocationBlockBegin(i);
+      
+      for (uint32_t p = i; p < phaseCount; p += invocationCount)
+        this->emitHsForkJoinPhase(m_hs.forkPhases[p]);
+      
+      for (uint32_t p = i; p < phaseCount; p += invocationCount)
+        this->emitHsPhaseOutputSetup(m_hs.forkPhases[p], outputPerPatch);
+      
+      this->emitHsInvocationBlockEnd();
+    }
+  }
+  
+  
+  void DxbcCompiler::emitHsPhaseOutputSetup(
+    const DxbcCompilerHsForkJoinPhase&      phase,
+          uint32_t                          outputPerPatch) {
+    uint32_t fltType = m_module.defFloatType(32);
+    uint32_t vecType = getVectorTypeId({ DxbcScalarType::Float32, 4 });
+    
+    for (const auto& output : phase.outputs) {
+      uint32_t registerIndex = m_module.constu32(output.regId);
+      
+      DxbcRegisterPointer srcReg;
+      srcReg.type = { DxbcScalarType::Float32, 4 };
+      srcReg.id = m_module.opAccessChain(
+        m_module.defPointerType(vecType, spv::StorageClassPrivate),
+        m_hs.outputPerPatch, 1, &registerIndex);
+      
+      if (output.sv != DxbcSystemValue::None
+       && output.sv != DxbcSystemValue::ClipDistance
+       && output.sv != DxbcSystemValue::CullDistance)
+        emitHsSystemValueStore(output.sv, output.regMask, emitValueLoad(srcReg));
+      
+      // Other phases may write different components of the
+      // same register, so only copy the declared components
+      for (uint32_t c = 0; c < 4; c++) {
+        if (!output.regMask[c])
+          continue;
+        
+        const std::array<uint32_t, 2> indices = {
+          registerIndex, m_module.constu32(c) };
+        
+        uint32_t srcPtr = m_module.opAccessChain(
+          m_module.defPointerType(fltType, spv::StorageClassPrivate),
+          m_hs.outputPerPatch, indices.size(), indices.data());
+        uint32_t dstPtr = m_module.opAccessChain(
+          m_module.defPointerType(fltType, spv::StorageClassOutput),
+          outputPerPatch, indices.size(), indices.data());
+        
+        m_module.opStore(dstPtr, m_module.opLoad(fltType, srcPtr));
+      }
+    }
+  }
+  
+  
+  bool DxbcCompiler::canRunHsForkPhasesInParallel() const {
+    // Join phases read the outputs of all fork phases,
+    // which are private to the invocation that ran them
+    if (!m_hs.joinPhases.empty()
+     || m_hs.forkPhases.size() < 2
+     || m_hs.vertexCountOut < 2)
+      return false;
+    
+    // All system value outputs must be declared within a
+    // fork phase, otherwise we cannot tell which invocation
+    // is responsible for writing them
+    size_t svCount = 0;
+    
+    for (const auto& phase : m_hs.forkPhases) {
+      for (const auto& output : phase.outputs) {
+        if (output.sv != DxbcSystemValue::None
+         && output.sv != DxbcSystemValue::ClipDistance
+         && output.sv != DxbcSystemValue::CullDistance)
+          svCount += 1;
+      }
+    }
+    
+    return svCount == m_oMappings.size();
+  }
+  
+  
   uint32_t DxbcCompiler::emitTessInterfacePerPatch(spv::StorageClass storageClass) {
     const char* name = "vPatch";
 
@@ -7127,6 +7666,19 @@ namespace dxvk {
   }
   
   
+  bool DxbcCompiler::isInputRegUsed(uint32_t regIdx) const {
+    // Only vertex and pixel shader inputs are accessed
+    // through v# registers exclusively, other stages
+    // may access them through other operand types.
+    if (m_programInfo.type() != DxbcProgramType::VertexShader
+     && m_programInfo.type() != DxbcProgramType::PixelShader)
+      return true;
+    
+    return m_analysis->inputDynamicIndex
+        || m_analysis->inputUsage.at(regIdx).readMask != DxbcRegMask();
+  }
+  
+  
   DxbcVectorType DxbcCompiler::getInputRegType(uint32_t regIdx) const {
     switch (m_programInfo.type()) {
       case DxbcProgramType::VertexShader: {
@@ -212,6 +212,8 @@ namespace dxvk {
     
     uint32_t instanceId         = 0;
     uint32_t instanceIdPtr      = 0;
+    
+    std::vector<DxbcSvMapping> outputs;
   };
   
   
@@ -565,6 +567,10 @@ namespace dxvk {
     void emitDclConstantBuffer(
       const DxbcShaderInstruction&  ins);
     
+    void emitDclConstantBufferPush(
+            uint32_t                regIdx,
+            uint32_t                numConstants);
+    
     void emitDclConstantBufferVar(
             uint32_t                regIdx,
             uint32_t                numConstants,
@@ -618,7 +624,7 @@ namespace dxvk {
     void emitDclGsInstanceCount(
       const DxbcShaderInstruction&  ins);
     
-    uint32_t emitDclUavCounter(
+    void emitDclUavCounter(
             uint32_t                regId);
     
     ////////////////////////
@@ -904,7 +910,7 @@ namespace dxvk {
     
     DxbcRegisterPointer emitGetAtomicPointer(
       const DxbcRegister&           operand,
-      const DxbcRegister&           address);
+      const DxbcRegisterValue&      address);
     
     ///////////////////////////////
     // Resource load/store methods
@@ -954,6 +960,10 @@ namespace dxvk {
       const DxbcRegister&           coordReg,
       const DxbcImageInfo&          imageInfo);
     
+    DxbcRegisterValue emitLoadAtomicAddress(
+      const DxbcRegister&           operand,
+      const DxbcRegister&           address);
+    
     //////////////////////////////
     // Operand load/store methods
     DxbcRegisterValue emitIndexLoad(
@@ -970,6 +980,9 @@ namespace dxvk {
     DxbcRegisterValue emitRegisterLoadRaw(
       const DxbcRegister&           reg);
     
+    DxbcRegisterValue emitConstBufLoad(
+      const DxbcRegister&           reg);
+    
     DxbcRegisterValue emitRegisterLoad(
       const DxbcRegister&           reg,
             DxbcRegMask             writeMask);
@@ -1054,6 +1067,24 @@ namespace dxvk {
     uint32_t emitUavWriteTest(
       const DxbcBufferInfo&         uav);
     
+    ///////////////////////////////
+    // Buffer bounds check methods
+    uint32_t emitQueryBufferElementCount(
+      const DxbcBufferInfo&         buffer,
+            bool                    isSsbo);
+    
+    uint32_t emitBufferBoundsTest(
+            DxbcRegisterValue       index,
+            uint32_t                elementCount);
+    
+    DxbcRegisterValue emitBufferBoundsClamp(
+            DxbcRegisterValue       index,
+            uint32_t                inBounds);
+    
+    DxbcRegisterValue emitBufferBoundsResult(
+            DxbcRegisterValue       value,
+            uint32_t                inBounds);
+    
     //////////////////////////////////////
     // Common function definition methods
     void emitInit();
@@ -1106,12 +1137,20 @@ namespace dxvk {
     void emitHsPhaseBarrier();
     
     void emitHsInvocationBlockBegin(
-            uint32_t                          count);
+            uint32_t                          invocation);
     
     void emitHsInvocationBlockEnd();
 
     void emitHsOutputSetup();
     
+    void emitHsForkPhasesParallel();
+    
+    void emitHsPhaseOutputSetup(
+      const DxbcCompilerHsForkJoinPhase&      phase,
+            uint32_t                          outputPerPatch);
+    
+    bool canRunHsForkPhasesInParallel() const;
+    
     uint32_t emitTessInterfacePerPatch(
             spv::StorageClass                 storageClass);
     
@@ -1184,6 +1223,9 @@ namespace dxvk {
     DxbcVectorType getInputRegType(
             uint32_t regIdx) const;
     
+    bool isInputRegUsed(
+            uint32_t regIdx) const;
+    
     DxbcVectorType getOutputRegType(
             uint32_t regIdx) const;
     
@@ -357,4 +357,65 @@ namespace dxvk {
     }
   }
   
-}
\ No newline at end of file
+  
+  DxbcInstructionStream::DxbcInstructionStream(DxbcCodeSlice code) {
+    DxbcDecodeContext decoder;
+    
+    // Operand pointers are stored as indices into the
+    // operand arrays first, since those arrays may be
+    // reallocated while the code is being decoded
+    std::vector<std::array<uint32_t, 3>> operands;
+    std::vector<RelIndex>                relIndices;
+    
+    while (!code.atEnd()) {
+      decoder.decodeInstruction(code);
+      
+      const DxbcShaderInstruction& ins = decoder.getInstruction();
+      
+      uint32_t dstIndex = m_registers.size();
+      uint32_t srcIndex = dstIndex + ins.dstCount;
+      uint32_t immIndex = m_immediates.size();
+      
+      for (uint32_t i = 0; i < ins.dstCount; i++)
+        m_registers.push_back(ins.dst[i]);
+      
+      for (uint32_t i = 0; i < ins.srcCount; i++)
+        m_registers.push_back(ins.src[i]);
+      
+      for (uint32_t i = 0; i < ins.immCount; i++)
+        m_immediates.push_back(ins.imm[i]);
+      
+      // Registers used for relative indexing are appended
+      // after the operands. They point into the decoder,
+      // which remains valid until the next instruction.
+      for (uint32_t r = dstIndex; r < m_registers.size(); r++) {
+        for (uint32_t i = 0; i < m_registers[r].idxDim; i++) {
+          const DxbcRegister* relReg = m_registers[r].idx[i].relReg;
+          
+          if (relReg != nullptr) {
+            relIndices.push_back({ r, i, uint32_t(m_registers.size()) });
+            m_registers.push_back(*relReg);
+          }
+        }
+      }
+      
+      m_instructions.push_back(ins);
+      operands.push_back({ dstIndex, srcIndex, immIndex });
+    }
+    
+    for (size_t i = 0; i < m_instructions.size(); i++) {
+      m_instructions[i].dst = m_registers.data() + operands[i][0];
+      m_instructions[i].src = m_registers.data() + operands[i][1];
+      m_instructions[i].imm = m_immediates.data() + operands[i][2];
+    }
+    
+    for (const auto& rel : relIndices)
+      m_registers[rel.reg].idx[rel.dim].relReg = &m_registers[rel.relReg];
+  }
+  
+  
+  DxbcInstructionStream::~DxbcInstructionStream() {
+    
+  }
+  
+}
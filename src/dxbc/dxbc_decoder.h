@@ -35,9 +35,10 @@ namespace dxvk {
    * access a constant buffer.
    */
   struct DxbcConstantBuffer {
-    uint32_t varId  = 0;
-    uint32_t specId = 0;
-    uint32_t size   = 0;
+    uint32_t varId     = 0;
+    uint32_t specId    = 0;
+    uint32_t size      = 0;
+    uint32_t pushVarId = 0;
   };
   
   /**
@@ -95,6 +96,7 @@ namespace dxvk {
     DxbcImageInfo     imageInfo;
     uint32_t          varId         = 0;
     uint32_t          ctrId         = 0;
+    uint32_t          ctrSpecId     = 0;
     uint32_t          specId        = 0;
     DxbcScalarType    sampledType   = DxbcScalarType::Float32;
     uint32_t          sampledTypeId = 0;
@@ -364,7 +366,8 @@ namespace dxvk {
    * Note that this structure may store pointer to
    * external structures, such as the original code
    * buffer. This is safe to use if and only if:
-   * - The \ref DxbcDecodeContext that created it
+   * - The \ref DxbcDecodeContext or the
+   *   \ref DxbcInstructionStream that created it
    *   still exists and was not moved
    * - The code buffer that was being decoded
    *   still exists and was not moved.
@@ -483,4 +486,51 @@ namespace dxvk {
     
   };
   
+  
+  /**
+   * \brief Decoded instruction stream
+   * 
+   * Decodes all instructions of a shader up front, so
+   * that the code can be processed multiple times without
+   * decoding it again. Operands, including registers used
+   * for relative indexing, are stored in shared arrays.
+   * 
+   * Custom data still points into the code buffer, which
+   * must therefore outlive the instruction stream.
+   */
+  class DxbcInstructionStream {
+    
+  public:
+    
+    DxbcInstructionStream(DxbcCodeSlice code);
+    ~DxbcInstructionStream();
+    
+    DxbcInstructionStream             (const DxbcInstructionStream&) = delete;
+    DxbcInstructionStream& operator = (const DxbcInstructionStream&) = delete;
+    
+    /**
+     * \brief Number of instructions
+     * \returns Instruction count
+     */
+    size_t size() const {
+      return m_instructions.size();
+    }
+    
+    auto begin() const { return m_instructions.cbegin(); }
+    auto end  () const { return m_instructions.cend(); }
+    
+  private:
+    
+    struct RelIndex {
+      uint32_t reg;
+      uint32_t dim;
+      uint32_t relReg;
+    };
+    
+    std::vector<DxbcShaderInstruction> m_instructions;
+    std::vector<DxbcRegister>          m_registers;
+    std::vector<DxbcImmediate>         m_immediates;
+    
+  };
+  
 }
\ No newline at end of file
@@ -2,7 +2,8 @@
 
 namespace dxvk {
   
-  DxbcHeader::DxbcHeader(DxbcReader& reader) {
+  DxbcHeader::DxbcHeader(DxbcReader& reader)
+  : m_file(reader) {
     // FourCC at the start of the file, must be 'DXBC'
     DxbcTag fourcc = reader.readTag();
     
@@ -14,12 +15,10 @@ namespace dxvk {
     reader.skip(1 * sizeof(uint32_t)); // Constant 1
     reader.skip(1 * sizeof(uint32_t)); // Bytecode length
     
-    // Number of chunks in the file
-    uint32_t chunkCount = reader.readu32();
-    
-    // Chunk offsets are stored immediately after
-    for (uint32_t i = 0; i < chunkCount; i++)
-      m_chunkOffsets.push_back(reader.readu32());
+    // Number of chunks in the file. The chunk offsets are
+    // stored immediately after, make sure they are valid.
+    m_chunkCount = reader.readu32();
+    reader.skip(m_chunkCount * sizeof(uint32_t));
   }
   
   
@@ -27,4 +26,27 @@ namespace dxvk {
     
   }
   
-}
\ No newline at end of file
+  
+  uint32_t DxbcHeader::chunkOffset(uint32_t chunkId) const {
+    if (chunkId >= m_chunkCount)
+      throw DxvkError("DxbcHeader::chunkOffset: Invalid chunk index");
+    
+    return m_file.clone(HeaderSize + chunkId * sizeof(uint32_t)).readu32();
+  }
+  
+  
+  DxbcReader DxbcHeader::chunkData(uint32_t chunkId, DxbcTag& tag) const {
+    // The chunk tag is stored at the beginning of each chunk
+    auto chunkReader = m_file.clone(this->chunkOffset(chunkId));
+    tag = chunkReader.readTag();
+    
+    // The chunk size follows right after the four-character
+    // code. This does not include the eight bytes that are
+    // consumed by the FourCC and chunk length entry.
+    auto chunkLength = chunkReader.readu32();
+    
+    chunkReader = chunkReader.clone(8);
+    return chunkReader.resize(chunkLength);
+  }
+  
+}
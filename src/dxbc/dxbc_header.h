@@ -1,7 +1,5 @@
 #pragma once
 
-#include <vector>
-
 #include "dxbc_reader.h"
 
 namespace dxvk {
@@ -24,7 +22,7 @@ namespace dxvk {
      * \returns Chunk count
      */
     uint32_t numChunks() const {
-      return m_chunkOffsets.size();
+      return m_chunkCount;
     }
     
     /**
@@ -35,14 +33,30 @@ namespace dxvk {
      * \param [in] chunkId Chunk index
      * \returns Byte offset of that chunk
      */
-    uint32_t chunkOffset(uint32_t chunkId) const {
-      return m_chunkOffsets.at(chunkId);
-    }
+    uint32_t chunkOffset(uint32_t chunkId) const;
+    
+    /**
+     * \brief Chunk contents
+     * 
+     * The returned reader references the byte
+     * code that the header was read from, and
+     * does not include the chunk header.
+     * \param [in] chunkId Chunk index
+     * \param [out] tag Chunk tag
+     * \returns Reader for the chunk contents
+     */
+    DxbcReader chunkData(uint32_t chunkId, DxbcTag& tag) const;
     
   private:
     
-    std::vector<uint32_t> m_chunkOffsets;
+    /// Size of the file header up to the chunk offsets
+    constexpr static uint32_t HeaderSize = 32;
+    
+    // The chunk offset table is read from the
+    // byte code directly rather than copied
+    DxbcReader m_file;
+    uint32_t   m_chunkCount = 0;
     
   };
   
-}
\ No newline at end of file
+}
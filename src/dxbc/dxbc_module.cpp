@@ -4,21 +4,12 @@
 
 namespace dxvk {
   
-  DxbcModule::DxbcModule(DxbcReader& reader)
-  : m_header(reader) {
-    for (uint32_t i = 0; i < m_header.numChunks(); i++) {
-      
-      // The chunk tag is stored at the beginning of each chunk
-      auto chunkReader = reader.clone(m_header.chunkOffset(i));
-      auto tag         = chunkReader.readTag();
-      
-      // The chunk size follows right after the four-character
-      // code. This does not include the eight bytes that are
-      // consumed by the FourCC and chunk length entry.
-      auto chunkLength = chunkReader.readu32();
-      
-      chunkReader = chunkReader.clone(8);
-      chunkReader = chunkReader.resize(chunkLength);
+  DxbcModule::DxbcModule(DxbcReader& reader) {
+    DxbcHeader header(reader);
+    
+    for (uint32_t i = 0; i < header.numChunks(); i++) {
+      DxbcTag tag;
+      auto chunkReader = header.chunkData(i, tag);
       
       if ((tag == "SHDR") || (tag == "SHEX"))
         m_shexChunk = new DxbcShex(chunkReader);
@@ -37,6 +28,36 @@ namespace dxvk {
   }
   
   
+  Rc<DxbcIsgn> DxbcModule::readInputSignature(DxbcReader& reader) {
+    DxbcHeader header(reader);
+    
+    for (uint32_t i = 0; i < header.numChunks(); i++) {
+      DxbcTag tag;
+      auto chunkReader = header.chunkData(i, tag);
+      
+      if ((tag == "ISGN") || (tag == "ISG1"))
+        return new DxbcIsgn(chunkReader, tag);
+    }
+    
+    return nullptr;
+  }
+  
+  
+  void DxbcModule::decode() const {
+    if (m_shexChunk == nullptr)
+      throw DxvkError("DxbcModule::decode: No SHDR/SHEX chunk");
+    
+    m_shexChunk->instructions();
+  }
+  
+  
+  size_t DxbcModule::instructionCount() const {
+    return m_shexChunk != nullptr
+      ? m_shexChunk->instructions().size()
+      : 0;
+  }
+  
+  
   Rc<DxvkShader> DxbcModule::compile(
     const DxbcModuleInfo& moduleInfo,
     const std::string&    fileName) const {
@@ -50,7 +71,7 @@ namespace dxvk {
       m_isgnChunk, m_osgnChunk,
       analysisInfo);
     
-    this->runAnalyzer(analyzer, m_shexChunk->slice());
+    this->runAnalyzer(analyzer, m_shexChunk->instructions());
     
     DxbcCompiler compiler(
       fileName, moduleInfo,
@@ -58,7 +79,7 @@ namespace dxvk {
       m_isgnChunk, m_osgnChunk,
       analysisInfo);
     
-    this->runCompiler(compiler, m_shexChunk->slice());
+    this->runCompiler(compiler, m_shexChunk->instructions());
     
     return compiler.finalize();
   }
@@ -84,30 +105,18 @@ namespace dxvk {
 
 
   void DxbcModule::runAnalyzer(
-          DxbcAnalyzer&       analyzer,
-          DxbcCodeSlice       slice) const {
-    DxbcDecodeContext decoder;
-    
-    while (!slice.atEnd()) {
-      decoder.decodeInstruction(slice);
-      
-      analyzer.processInstruction(
-        decoder.getInstruction());
-    }
+          DxbcAnalyzer&           analyzer,
+    const DxbcInstructionStream&  instructions) const {
+    for (const auto& ins : instructions)
+      analyzer.processInstruction(ins);
   }
   
   
   void DxbcModule::runCompiler(
-          DxbcCompiler&       compiler,
-          DxbcCodeSlice       slice) const {
-    DxbcDecodeContext decoder;
-    
-    while (!slice.atEnd()) {
-      decoder.decodeInstruction(slice);
-      
-      compiler.processInstruction(
-        decoder.getInstruction());
-    }
+          DxbcCompiler&           compiler,
+    const DxbcInstructionStream&  instructions) const {
+    for (const auto& ins : instructions)
+      compiler.processInstruction(ins);
   }
   
 }
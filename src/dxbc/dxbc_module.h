@@ -48,6 +48,38 @@ namespace dxvk {
     Rc<DxbcIsgn> isgn() const { return m_isgnChunk; }
     Rc<DxbcIsgn> osgn() const { return m_osgnChunk; }
     
+    /**
+     * \brief Reads the input signature only
+     * 
+     * Much cheaper than creating a module if only
+     * the input signature is needed, since the code
+     * chunk is neither copied nor decoded.
+     * \param [in] reader Byte code reader
+     * \returns Input signature, or \c nullptr if
+     *    the byte code has no input signature
+     */
+    static Rc<DxbcIsgn> readInputSignature(
+            DxbcReader&           reader);
+    
+    /**
+     * \brief Decodes the shader code
+     * 
+     * Decodes all instructions, which otherwise happens
+     * on first use, so that malformed code can be rejected
+     * before the module gets compiled. The decoded code is
+     * reused by subsequent compilations.
+     */
+    void decode() const;
+    
+    /**
+     * \brief Number of instructions
+     * 
+     * Decodes the shader code if that has
+     * not happened yet.
+     * \returns Decoded instruction count
+     */
+    size_t instructionCount() const;
+    
     /**
      * \brief Compiles DXBC shader to SPIR-V module
      * 
@@ -76,19 +108,17 @@ namespace dxvk {
     
   private:
     
-    DxbcHeader   m_header;
-    
     Rc<DxbcIsgn> m_isgnChunk;
     Rc<DxbcIsgn> m_osgnChunk;
     Rc<DxbcShex> m_shexChunk;
     
     void runAnalyzer(
-            DxbcAnalyzer&       analyzer,
-            DxbcCodeSlice       slice) const;
+            DxbcAnalyzer&           analyzer,
+      const DxbcInstructionStream&  instructions) const;
     
     void runCompiler(
-            DxbcCompiler&       compiler,
-            DxbcCodeSlice       slice) const;
+            DxbcCompiler&           compiler,
+      const DxbcInstructionStream&  instructions) const;
     
   };
   
@@ -0,0 +1,51 @@
+#include <cstring>
+
+#include "dxbc_name_table.h"
+
+namespace dxvk {
+
+  std::mutex                                DxbcNameTable::s_mutex;
+  std::deque<std::string>                   DxbcNameTable::s_names;
+  std::unordered_multimap<size_t, uint32_t> DxbcNameTable::s_lookup;
+
+
+  const char* DxbcNameTable::intern(
+    const char*           name,
+          size_t          length) {
+    const size_t hash = hashName(name, length);
+
+    std::lock_guard<std::mutex> lock(s_mutex);
+
+    auto range = s_lookup.equal_range(hash);
+
+    for (auto e = range.first; e != range.second; e++) {
+      const std::string& entry = s_names[e->second];
+
+      if (entry.size() == length
+       && !std::memcmp(entry.data(), name, length))
+        return entry.c_str();
+    }
+
+    // Elements of a deque do not move when
+    // new elements are added to the end
+    s_lookup.insert({ hash, uint32_t(s_names.size()) });
+    s_names.emplace_back(name, length);
+    return s_names.back().c_str();
+  }
+
+
+  size_t DxbcNameTable::hashName(
+    const char*           name,
+          size_t          length) {
+    // FNV-1a, which is good enough for short strings
+    size_t hash = 2166136261u;
+
+    for (size_t i = 0; i < length; i++) {
+      hash ^= uint8_t(name[i]);
+      hash *= 16777619u;
+    }
+
+    return hash;
+  }
+
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "dxbc_include.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Semantic name table
+   *
+   * Interns semantic names found in shader signatures.
+   * Applications typically use a few dozen distinct
+   * names across thousands of shaders, so storing each
+   * name once avoids allocating strings for every single
+   * signature entry. Interned names stay valid for the
+   * lifetime of the process, independently of the byte
+   * code that they were read from.
+   */
+  class DxbcNameTable {
+
+  public:
+
+    /**
+     * \brief Interns a name
+     *
+     * Looking up a name that has already been
+     * interned does not allocate any memory.
+     * \param [in] name The name. Does not need
+     *    to be null-terminated.
+     * \param [in] length Name length, in characters
+     * \returns Null-terminated interned name
+     */
+    static const char* intern(
+      const char*           name,
+            size_t          length);
+
+  private:
+
+    static std::mutex                                 s_mutex;
+    static std::deque<std::string>                    s_names;
+    static std::unordered_multimap<size_t, uint32_t>  s_lookup;
+
+    static size_t hashName(
+      const char*           name,
+            size_t          length);
+
+  };
+
+}
@@ -21,10 +21,19 @@ namespace dxvk {
       = (devInfo.coreSubgroup.subgroupSize >= 4)
      && (devInfo.coreSubgroup.supportedStages     & VK_SHADER_STAGE_FRAGMENT_BIT)
      && (devInfo.coreSubgroup.supportedOperations & VK_SUBGROUP_FEATURE_BALLOT_BIT);
+    useSubgroupOpsForAtomicCounters
+      = (devInfo.coreSubgroup.supportedStages     & VK_SHADER_STAGE_COMPUTE_BIT)
+     && (devInfo.coreSubgroup.supportedOperations & VK_SUBGROUP_FEATURE_BASIC_BIT)
+     && (devInfo.coreSubgroup.supportedOperations & VK_SUBGROUP_FEATURE_BALLOT_BIT);
     useRawSsbo
       = (devInfo.core.properties.limits.minStorageBufferOffsetAlignment <= sizeof(uint32_t));
+    usePushConstants
+      = (devInfo.core.properties.limits.maxPushConstantsSize >= MaxPushConstantSize);
     
     zeroInitWorkgroupMemory = options.zeroInitWorkgroupMemory;
+    optimizeSpirv           = options.optimizeShaders;
+    parallelizeHsForkPhases = options.parallelForkPhases;
+    useBufferBoundsChecks   = !devFeatures.core.features.robustBufferAccess;
     
     // Disable early discard on RADV due to GPU hangs
     // Disable early discard on Nvidia because it may hurt performance
@@ -33,8 +42,10 @@ namespace dxvk {
       useSubgroupOpsForEarlyDiscard = false;
     
     // Apply shader-related options
-    applyTristate(useSubgroupOpsForEarlyDiscard, device->config().useEarlyDiscard);
-    applyTristate(useRawSsbo,                    device->config().useRawSsbo);
+    applyTristate(useSubgroupOpsForEarlyDiscard,   device->config().useEarlyDiscard);
+    applyTristate(useSubgroupOpsForAtomicCounters, device->config().useSubgroupAtomics);
+    applyTristate(useRawSsbo,                      device->config().useRawSsbo);
+    applyTristate(usePushConstants,                device->config().usePushConstants);
   }
   
 }
\ No newline at end of file
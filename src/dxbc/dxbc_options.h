@@ -6,6 +6,13 @@ namespace dxvk {
 
   struct D3D11Options;
   
+  /**
+   * \brief Shader compiler options
+   * 
+   * Since these options affect the generated code, they
+   * are hashed into the key for the on-disk shader cache.
+   * Members must be laid out without any padding.
+   */
   struct DxbcOptions {
     DxbcOptions();
     DxbcOptions(const Rc<DxvkDevice>& device, const D3D11Options& options);
@@ -17,12 +24,31 @@ namespace dxvk {
     /// shader invocations if derivatives remain valid.
     bool useSubgroupOpsForEarlyDiscard = false;
 
+    /// Use subgroup operations to perform only one
+    /// UAV counter update per subgroup in compute shaders.
+    bool useSubgroupOpsForAtomicCounters = false;
+
     /// Use SSBOs instead of texel buffers
     /// for raw and structured buffers.
     bool useRawSsbo = false;
 
+    /// Allow passing one small constant
+    /// buffer via push constants.
+    bool usePushConstants = false;
+
     /// Clear thread-group shared memory to zero
     bool zeroInitWorkgroupMemory = false;
+
+    /// Run the SPIR-V optimizer on generated code
+    bool optimizeSpirv = false;
+
+    /// Distribute hull shader fork phases
+    /// across control point invocations.
+    bool parallelizeHsForkPhases = false;
+
+    /// Emit bounds checks for buffer accesses that
+    /// are not covered by robust buffer access.
+    bool useBufferBoundsChecks = false;
   };
   
 }
\ No newline at end of file
@@ -12,13 +12,24 @@ namespace dxvk {
   
   
   std::string DxbcReader::readString() {
-    std::string result;
+    size_t length = 0;
+    const char* str = this->readStringRef(length);
+    return std::string(str, length);
+  }
+  
+  
+  const char* DxbcReader::readStringRef(size_t& length) {
+    const char* str = m_data + m_pos;
+    const void* end = m_pos < m_size
+      ? std::memchr(str, '\0', m_size - m_pos)
+      : nullptr;
     
-    while (m_data[m_pos] != '\0')
-      result.push_back(m_data[m_pos++]);
+    if (end == nullptr)
+      throw DxvkError("DxbcReader::readStringRef: Unterminated string");
     
-    m_pos++;
-    return result;
+    length = reinterpret_cast<const char*>(end) - str;
+    m_pos += length + 1;
+    return str;
   }
   
   
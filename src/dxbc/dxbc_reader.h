@@ -43,6 +43,17 @@ namespace dxvk {
     
     std::string readString();
     
+    /**
+     * \brief Reads a string without copying it
+     * 
+     * The returned pointer references the byte code
+     * directly and is only valid as long as the byte
+     * code itself is.
+     * \param [out] length String length
+     * \returns Pointer to the null-terminated string
+     */
+    const char* readStringRef(size_t& length);
+    
     void read(void* dst, size_t n);
     
     void skip(size_t n);
@@ -2,6 +2,7 @@
 
 #include "dxvk_buffer.h"
 #include "dxvk_descriptor.h"
+#include "dxvk_hash.h"
 #include "dxvk_image.h"
 #include "dxvk_limits.h"
 #include "dxvk_sampler.h"
@@ -77,6 +78,19 @@ namespace dxvk {
         m_slots[i] = 0;
     }
     
+    /**
+     * \brief Computes hash
+     * \returns Hash over all binding states
+     */
+    size_t hash() const {
+      DxvkHashState state;
+      
+      for (uint32_t i = 0; i < IntCount; i++)
+        state.add(m_slots[i]);
+      
+      return state;
+    }
+    
   private:
     
     uint32_t m_slots[IntCount];
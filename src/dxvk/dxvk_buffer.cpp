@@ -24,6 +24,8 @@ namespace dxvk {
     m_physSlice.offset = 0;
     m_physSlice.length = m_physSliceLength;
     m_physSlice.mapPtr = m_buffer.memory.mapPtr(0);
+    
+    m_hostData = m_physSlice.mapPtr != nullptr;
   }
 
 
@@ -203,9 +203,35 @@ namespace dxvk {
      * \returns Previous buffer slice
      */
     DxvkBufferSliceHandle rename(const DxvkBufferSliceHandle& slice) {
+      m_hostData = slice.mapPtr != nullptr;
       return std::exchange(m_physSlice, slice);
     }
     
+    /**
+     * \brief Checks whether mapped data is current
+     * 
+     * This is the case if the buffer is mapped to host
+     * memory and has not been written by any GPU command
+     * since the backing resource was last replaced. The
+     * context can then read the buffer contents while
+     * recording commands, e.g. to emit push constants.
+     * \returns \c true if the mapped data is current
+     */
+    bool hasHostData() const {
+      return m_hostData;
+    }
+    
+    /**
+     * \brief Marks buffer as written by the GPU
+     * 
+     * Called by the context when recording commands that
+     * write to the buffer. Subsequent calls to \ref hasHostData
+     * will return \c false until the buffer is invalidated.
+     */
+    void markGpuWrite() {
+      m_hostData = false;
+    }
+    
     /**
      * \brief Transform feedback vertex stride
      * 
@@ -256,6 +282,7 @@ namespace dxvk {
     DxvkBufferSliceHandle   m_physSlice;
 
     uint32_t                m_vertexStride = 0;
+    bool                    m_hostData     = false;
     
     sync::Spinlock m_freeMutex;
     sync::Spinlock m_swapMutex;
@@ -23,7 +23,8 @@ namespace dxvk {
           DxvkPipelineManager*    pipeMgr,
     const Rc<DxvkShader>&         cs)
   : m_vkd(pipeMgr->m_device->vkd()),
-    m_pipeMgr(pipeMgr) {
+    m_pipeMgr(pipeMgr),
+    m_cs(cs) {
     DxvkDescriptorSlotMapping slotMapping;
     cs->defineResourceSlots(slotMapping);
 
@@ -31,77 +32,113 @@ namespace dxvk {
       m_pipeMgr->m_device->options().maxNumDynamicUniformBuffers,
       m_pipeMgr->m_device->options().maxNumDynamicStorageBuffers);
     
+    DxvkShaderOptions shaderOptions = cs->shaderOptions();
+
+    DxvkPushConstantRange pushConstants = { 0, VkShaderStageFlagBits(0), 0, 0 };
+
+    if (shaderOptions.pushConstSize) {
+      pushConstants.slot   = shaderOptions.pushConstSlot;
+      pushConstants.stage  = VK_SHADER_STAGE_COMPUTE_BIT;
+      pushConstants.stages = VK_SHADER_STAGE_COMPUTE_BIT;
+      pushConstants.size   = shaderOptions.pushConstSize;
+    }
+    
     m_layout = new DxvkPipelineLayout(m_vkd,
       slotMapping.bindingCount(),
       slotMapping.bindingInfos(),
+      pushConstants,
       VK_PIPELINE_BIND_POINT_COMPUTE);
     
     DxvkShaderModuleCreateInfo moduleInfo;
     moduleInfo.fsDualSrcBlend = false;
+    moduleInfo.outputMask     = ~0u;
 
-    m_cs = cs->createShaderModule(m_vkd, slotMapping, moduleInfo);
+    m_csModule = cs->createShaderModule(m_vkd, slotMapping, moduleInfo);
   }
   
   
   DxvkComputePipeline::~DxvkComputePipeline() {
     for (const auto& instance : m_pipelines)
-      this->destroyPipeline(instance.pipeline);
+      this->destroyPipeline(instance.second.pipeline);
   }
   
   
   VkPipeline DxvkComputePipeline::getPipelineHandle(
     const DxvkComputePipelineStateInfo& state) {
-    VkPipeline newPipelineHandle = VK_NULL_HANDLE;
+    VkPipeline pipelineHandle = VK_NULL_HANDLE;
 
     { std::lock_guard<sync::Spinlock> lock(m_mutex);
 
-      if (this->findPipeline(state, newPipelineHandle))
-        return newPipelineHandle;
-    
-      // If no pipeline instance exists with the given state
-      // vector, create a new one and add it to the list.
-      newPipelineHandle = this->compilePipeline(state, m_basePipeline);
-      
-      // Add new pipeline to the set
-      m_pipelines.push_back({ state, newPipelineHandle });
-      m_pipeMgr->m_numComputePipelines += 1;
+      auto instance = this->findInstance(state);
+
+      if (instance == nullptr) {
+        // If no pipeline instance exists with the given state
+        // vector, create a new one and add it to the list.
+        instance = this->createInstance(state, DxvkPipelineCompileType::Sync);
+      }
+
+      if (instance->used)
+        return instance->pipeline;
       
-      if (!m_basePipeline && newPipelineHandle)
-        m_basePipeline = newPipelineHandle;
+      instance->used = true;
+      pipelineHandle = instance->pipeline;
     }
     
-    if (newPipelineHandle != VK_NULL_HANDLE)
+    if (pipelineHandle != VK_NULL_HANDLE)
       this->writePipelineStateToCache(state);
     
-    return newPipelineHandle;
+    return pipelineHandle;
+  }
+  
+  
+  void DxvkComputePipeline::compilePipeline(
+    const DxvkComputePipelineStateInfo& state) {
+    std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+    if (this->findInstance(state) == nullptr)
+      this->createInstance(state, DxvkPipelineCompileType::Async);
+  }
+  
+  
+  DxvkComputePipeline::PipelineStruct* DxvkComputePipeline::findInstance(
+    const DxvkComputePipelineStateInfo& state) {
+    auto instance = m_pipelines.find(state);
+    
+    return instance != m_pipelines.end()
+      ? &instance->second
+      : nullptr;
   }
   
   
-  bool DxvkComputePipeline::findPipeline(
+  DxvkComputePipeline::PipelineStruct* DxvkComputePipeline::createInstance(
     const DxvkComputePipelineStateInfo& state,
-          VkPipeline&                   pipeline) const {
-    for (const PipelineStruct& pair : m_pipelines) {
-      if (pair.stateVector == state) {
-        pipeline = pair.pipeline;
-        return true;
-      }
-    }
+          DxvkPipelineCompileType       type) {
+    VkPipeline newPipelineHandle = this->createPipeline(state, m_basePipeline, type);
+    
+    // Add new pipeline to the set
+    auto instance = m_pipelines.insert({ state, { newPipelineHandle, false } });
+    m_pipeMgr->m_numComputePipelines += 1;
+    
+    if (!m_basePipeline && newPipelineHandle)
+      m_basePipeline = newPipelineHandle;
     
-    return false;
+    return &instance.first->second;
   }
   
   
-  VkPipeline DxvkComputePipeline::compilePipeline(
+  VkPipeline DxvkComputePipeline::createPipeline(
     const DxvkComputePipelineStateInfo& state,
-          VkPipeline                    baseHandle) const {
+          VkPipeline                    baseHandle,
+          DxvkPipelineCompileType       type) const {
     std::vector<VkDescriptorSetLayoutBinding> bindings;
 
     if (Logger::logLevel() <= LogLevel::Debug) {
       Logger::debug("Compiling compute pipeline..."); 
-      Logger::debug(str::format("  cs  : ", m_cs->shader()->debugName()));
+      Logger::debug(str::format("  cs  : ", m_cs->debugName()));
     }
     
     DxvkSpecConstantData specData;
+    specData.pushConstantStage = uint32_t(m_layout->pushConstantRange().stage);
     
     for (uint32_t i = 0; i < MaxNumActiveBindings; i++)
       specData.activeBindings[i] = state.bsBindingMask.isBound(i) ? VK_TRUE : VK_FALSE;
@@ -118,7 +155,7 @@ namespace dxvk {
     info.flags                = baseHandle == VK_NULL_HANDLE
       ? VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT
       : VK_PIPELINE_CREATE_DERIVATIVE_BIT;
-    info.stage                = m_cs->stageInfo(&specInfo);
+    info.stage                = m_csModule->stageInfo(&specInfo);
     info.layout               = m_layout->pipelineLayout();
     info.basePipelineHandle   = baseHandle;
     info.basePipelineIndex    = -1;
@@ -130,13 +167,25 @@ namespace dxvk {
     if (m_vkd->vkCreateComputePipelines(m_vkd->device(),
           m_pipeMgr->m_cache->handle(), 1, &info, nullptr, &pipeline) != VK_SUCCESS) {
       Logger::err("DxvkComputePipeline: Failed to compile pipeline");
-      Logger::err(str::format("  cs  : ", m_cs->shader()->debugName()));
+      Logger::err(str::format("  cs  : ", m_cs->debugName()));
       return VK_NULL_HANDLE;
     }
     
     auto t1 = std::chrono::high_resolution_clock::now();
-    auto td = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
-    Logger::debug(str::format("DxvkComputePipeline: Finished in ", td.count(), " ms"));
+    auto td = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+    Logger::debug(str::format("DxvkComputePipeline: Finished in ", td.count() / 1000, " ms"));
+    
+    Rc<DxvkShaderStats> shaderStats = m_pipeMgr->m_device->shaderStats();
+
+    if (shaderStats != nullptr)
+      shaderStats->addPipeline(m_cs->getShaderKey(), td.count());
+    
+    if (m_pipeMgr->recordCompileTime(type, td.count())) {
+      Logger::info(str::format("DxvkComputePipeline: Slow ",
+        type == DxvkPipelineCompileType::Sync ? "on-demand" : "background",
+        " compile took ", td.count() / 1000, " ms"));
+      Logger::info(str::format("  cs  : ", m_cs->debugName()));
+    }
     return pipeline;
   }
 
@@ -146,17 +195,23 @@ namespace dxvk {
   }
   
   
-  void DxvkComputePipeline::writePipelineStateToCache(
-    const DxvkComputePipelineStateInfo& state) const {
-    if (m_pipeMgr->m_stateCache == nullptr)
-      return;
-    
+  DxvkStateCacheKey DxvkComputePipeline::getStateCacheKey() const {
     DxvkStateCacheKey key;
 
     if (m_cs != nullptr)
       key.cs = m_cs->getShaderKey();
 
-    m_pipeMgr->m_stateCache->addComputePipeline(key, state);
+    return key;
+  }
+
+
+  void DxvkComputePipeline::writePipelineStateToCache(
+    const DxvkComputePipelineStateInfo& state) const {
+    if (m_pipeMgr->m_stateCache == nullptr)
+      return;
+    
+    m_pipeMgr->m_stateCache->addComputePipeline(
+      getStateCacheKey(), state);
   }
   
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #pragma once
 
 #include <atomic>
-#include <vector>
+#include <unordered_map>
 
 #include "dxvk_bind_mask.h"
 #include "dxvk_pipecache.h"
@@ -14,6 +14,7 @@ namespace dxvk {
   
   class DxvkDevice;
   class DxvkPipelineManager;
+  struct DxvkStateCacheKey;
   
   /**
    * \brief Compute pipeline state info
@@ -22,6 +23,14 @@ namespace dxvk {
     bool operator == (const DxvkComputePipelineStateInfo& other) const;
     bool operator != (const DxvkComputePipelineStateInfo& other) const;
     
+    bool eq(const DxvkComputePipelineStateInfo& other) const {
+      return *this == other;
+    }
+    
+    size_t hash() const {
+      return bsBindingMask.hash();
+    }
+    
     DxvkBindingMask bsBindingMask;
   };
   
@@ -64,35 +73,59 @@ namespace dxvk {
     VkPipeline getPipelineHandle(
       const DxvkComputePipelineStateInfo& state);
     
+    /**
+     * \brief Compiles a pipeline
+     * 
+     * Compiles the given pipeline ahead of time and
+     * stores the result for future use. Used by the
+     * state cache, this does not count as a use of
+     * the pipeline by the application.
+     * \param [in] state Pipeline state
+     */
+    void compilePipeline(
+      const DxvkComputePipelineStateInfo& state);
+    
   private:
     
     struct PipelineStruct {
-      DxvkComputePipelineStateInfo stateVector;
       VkPipeline                   pipeline;
+      bool                         used;
     };
     
     Rc<vk::DeviceFn>        m_vkd;
     DxvkPipelineManager*    m_pipeMgr;
     
+    Rc<DxvkShader>          m_cs;
     Rc<DxvkPipelineLayout>  m_layout;
-    Rc<DxvkShaderModule>    m_cs;
+    Rc<DxvkShaderModule>    m_csModule;
     
+    // Pipeline instances, looked up by their state vector
     sync::Spinlock              m_mutex;
-    std::vector<PipelineStruct> m_pipelines;
+    
+    std::unordered_map<
+      DxvkComputePipelineStateInfo,
+      PipelineStruct,
+      DxvkHash, DxvkEq> m_pipelines;
     
     VkPipeline m_basePipeline = VK_NULL_HANDLE;
     
-    bool findPipeline(
+    PipelineStruct* findInstance(
+      const DxvkComputePipelineStateInfo& state);
+    
+    PipelineStruct* createInstance(
       const DxvkComputePipelineStateInfo& state,
-            VkPipeline&                   pipeline) const;
+            DxvkPipelineCompileType       type);
     
-    VkPipeline compilePipeline(
+    VkPipeline createPipeline(
       const DxvkComputePipelineStateInfo& state,
-            VkPipeline                    baseHandle) const;
+            VkPipeline                    baseHandle,
+            DxvkPipelineCompileType       type) const;
     
     void destroyPipeline(
             VkPipeline                    pipeline);
 
+    DxvkStateCacheKey getStateCacheKey() const;
+
     void writePipelineStateToCache(
       const DxvkComputePipelineStateInfo& state) const;
     
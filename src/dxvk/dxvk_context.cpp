@@ -281,6 +281,8 @@ namespace dxvk {
       buffer->info().access);
     
     m_cmd->trackResource(buffer);
+
+    this->trackBufferGpuWrite(buffer);
   }
   
   
@@ -684,6 +686,8 @@ namespace dxvk {
 
     m_cmd->trackResource(dstBuffer);
     m_cmd->trackResource(srcBuffer);
+
+    this->trackBufferGpuWrite(dstBuffer);
   }
   
   
@@ -1370,6 +1374,8 @@ namespace dxvk {
     const Rc<DxvkBuffer>&           buffer,
     const DxvkBufferSliceHandle&    slice) {
     // Allocate new backing resource
+    bool hadHostData = buffer->hasHostData();
+    
     DxvkBufferSliceHandle prevSlice = buffer->rename(slice);
     m_cmd->freeBufferSlice(buffer, prevSlice);
     
@@ -1397,7 +1403,13 @@ namespace dxvk {
 
     if (usage & (VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT
                | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)) {
-      if (prevSlice.handle != slice.handle) {
+      // If the host copy of a constant buffer becomes current
+      // again, the push constant path can be re-enabled, which
+      // requires the binding state to be re-evaluated.
+      bool hostDataChanged = (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        && !hadHostData && buffer->hasHostData();
+      
+      if (prevSlice.handle != slice.handle || hostDataChanged) {
         m_flags.set(DxvkContextFlag::GpDirtyResources,
                     DxvkContextFlag::CpDirtyResources);
       } else {
@@ -1499,6 +1511,8 @@ namespace dxvk {
       buffer->info().access);
 
     m_cmd->trackResource(buffer);
+
+    this->trackBufferGpuWrite(buffer);
   }
   
   
@@ -2787,6 +2801,9 @@ namespace dxvk {
       this->updateShaderDescriptorSetBinding(
         VK_PIPELINE_BIND_POINT_COMPUTE, m_cpSet,
         m_state.cp.pipeline->layout());
+      
+      this->updatePushConstants(
+        m_state.cp.pipeline->layout());
     }
 
     m_flags.clr(
@@ -2830,6 +2847,9 @@ namespace dxvk {
       this->updateShaderDescriptorSetBinding(
         VK_PIPELINE_BIND_POINT_GRAPHICS, m_gpSet,
         m_state.gp.pipeline->layout());
+      
+      this->updatePushConstants(
+        m_state.gp.pipeline->layout());
     }
 
     m_flags.clr(
@@ -2844,6 +2864,14 @@ namespace dxvk {
     const DxvkPipelineLayout*     layout) {
     bool updatePipelineState = false;
     
+    // Resource slot of the constant buffer that the
+    // pipeline may read from push constant memory
+    const DxvkPushConstantRange& pushConstants = layout->pushConstantRange();
+
+    uint32_t pushConstSlot = pushConstants.stages
+      ? pushConstants.slot
+      : ~0u;
+    
     // If the depth attachment is also bound as a shader
     // resource, we have to use the appropriate layout
     VkImage       depthImage  = VK_NULL_HANDLE;
@@ -2914,7 +2942,12 @@ namespace dxvk {
         case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
         case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
           if (res.bufferSlice.defined()) {
-            updatePipelineState |= bindMask.setBound(i);
+            // For the constant buffer that may be passed via push
+            // constants, the binding state indicates whether the
+            // push data is valid. Bind the descriptor either way.
+            updatePipelineState |= binding.slot != pushConstSlot || res.bufferSlice.buffer()->hasHostData()
+              ? bindMask.setBound(i)
+              : bindMask.setUnbound(i);
             m_descInfos[i] = res.bufferSlice.getDescriptor();
             
             m_cmd->trackResource(res.bufferSlice.buffer());
@@ -2926,7 +2959,9 @@ namespace dxvk {
         case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
         case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
           if (res.bufferSlice.defined()) {
-            updatePipelineState |= bindMask.setBound(i);
+            updatePipelineState |= binding.slot != pushConstSlot || res.bufferSlice.buffer()->hasHostData()
+              ? bindMask.setBound(i)
+              : bindMask.setUnbound(i);
             m_descInfos[i] = res.bufferSlice.getDescriptor();
             m_descInfos[i].buffer.offset = 0;
             
@@ -2989,6 +3024,31 @@ namespace dxvk {
   }
   
   
+  void DxvkContext::updatePushConstants(
+    const DxvkPipelineLayout*     layout) {
+    const DxvkPushConstantRange& range = layout->pushConstantRange();
+
+    if (!range.stages)
+      return;
+    
+    // Constant buffer contents can only change on the host through
+    // invalidation, which dirties the descriptor offsets, so this
+    // only runs when the offsets are rebound. If the buffer contents
+    // are not available on the host, the shader reads the descriptor.
+    std::array<char, MaxPushConstantSize> data = { };
+
+    const auto& res = m_rc[range.slot];
+
+    if (res.bufferSlice.defined() && res.bufferSlice.buffer()->hasHostData()) {
+      std::memcpy(data.data(), res.bufferSlice.mapPtr(0),
+        std::min<VkDeviceSize>(range.size, res.bufferSlice.length()));
+    }
+
+    m_cmd->cmdPushConstants(layout->pipelineLayout(),
+      range.stages, 0, range.size, data.data());
+  }
+  
+  
   void DxvkContext::updateFramebuffer() {
     if (m_flags.test(DxvkContextFlag::GpDirtyFramebuffer)) {
       m_flags.clr(DxvkContextFlag::GpDirtyFramebuffer);
@@ -3441,5 +3501,21 @@ namespace dxvk {
         m_cmd->trackResource(m_state.id.argBuffer.buffer());
     }
   }
+
+
+  void DxvkContext::trackBufferGpuWrite(
+    const Rc<DxvkBuffer>&           buffer) {
+    if (!buffer->hasHostData())
+      return;
+    
+    // Constant buffer contents that were pushed from host memory
+    // so far are now stale, so the binding state has to change
+    buffer->markGpuWrite();
+
+    if (buffer->info().usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) {
+      m_flags.set(DxvkContextFlag::GpDirtyResources,
+                  DxvkContextFlag::CpDirtyResources);
+    }
+  }
   
 }
\ No newline at end of file
@@ -889,6 +889,9 @@ namespace dxvk {
             VkDescriptorSet         set,
       const DxvkPipelineLayout*     layout);
 
+    void updatePushConstants(
+      const DxvkPipelineLayout*     layout);
+
     void updateFramebuffer();
     
     void updateIndexBufferBinding();
@@ -920,6 +923,9 @@ namespace dxvk {
             VkDescriptorSetLayout     layout);
 
     void trackDrawBuffer();
+
+    void trackBufferGpuWrite(
+      const Rc<DxvkBuffer>&           buffer);
     
   };
   
@@ -16,6 +16,7 @@ namespace dxvk {
     m_properties        (adapter->deviceProperties()),
     m_memory            (new DxvkMemoryAllocator    (this)),
     m_renderPassPool    (new DxvkRenderPassPool     (vkd)),
+    m_shaderStats       (DxvkShaderStats::createFromEnv()),
     m_pipelineManager   (new DxvkPipelineManager    (this, m_renderPassPool.ptr())),
     m_metaClearObjects  (new DxvkMetaClearObjects   (vkd)),
     m_metaCopyObjects   (new DxvkMetaCopyObjects    (vkd)),
@@ -34,6 +35,11 @@ namespace dxvk {
     m_vkd->vkGetDeviceQueue(m_vkd->device(),
       m_presentQueue.queueFamily, 0,
       &m_presentQueue.queueHandle);
+    
+    std::string useShaderCache = env::getEnvVar("DXVK_SHADER_CACHE");
+    
+    if (useShaderCache != "0" && m_options.enableShaderCache)
+      m_shaderCache = new DxvkShaderCache();
   }
   
   
@@ -194,12 +200,28 @@ namespace dxvk {
   DxvkStatCounters DxvkDevice::getStatCounters() {
     DxvkMemoryStats mem = m_memory->getMemoryStats();
     DxvkPipelineCount pipe = m_pipelineManager->getPipelineCount();
+    DxvkPipelineCompileStats comp = m_pipelineManager->getCompileStats();
+    DxvkShaderCodeStats code = DxvkShader::getCodeStats();
     
     DxvkStatCounters result;
     result.setCtr(DxvkStatCounter::MemoryAllocated,   mem.memoryAllocated);
     result.setCtr(DxvkStatCounter::MemoryUsed,        mem.memoryUsed);
+    result.setCtr(DxvkStatCounter::ShaderCodeCompressed,    code.compressedSize);
+    result.setCtr(DxvkStatCounter::ShaderCodeUncompressed,  code.uncompressedSize);
+    result.setCtr(DxvkStatCounter::ShaderCodeCached,        code.cachedSize);
     result.setCtr(DxvkStatCounter::PipeCountGraphics, pipe.numGraphicsPipelines);
     result.setCtr(DxvkStatCounter::PipeCountCompute,  pipe.numComputePipelines);
+    result.setCtr(DxvkStatCounter::PipeCompiledFull,        comp.numFullPipelines);
+    result.setCtr(DxvkStatCounter::PipeCompiledDerived,     comp.numDerivedPipelines);
+    result.setCtr(DxvkStatCounter::PipeCompileTimeFull,     comp.fullCompileTime);
+    result.setCtr(DxvkStatCounter::PipeCompileTimeDerived,  comp.derivedCompileTime);
+    
+    DxvkPipelineCompileTimes sync  = m_pipelineManager->getCompileTimes(DxvkPipelineCompileType::Sync);
+    DxvkPipelineCompileTimes async = m_pipelineManager->getCompileTimes(DxvkPipelineCompileType::Async);
+    result.setCtr(DxvkStatCounter::PipeCompiledSync,        sync.numPipelines);
+    result.setCtr(DxvkStatCounter::PipeCompiledAsync,       async.numPipelines);
+    result.setCtr(DxvkStatCounter::PipeCompileTimeSync,     sync.compileTime);
+    result.setCtr(DxvkStatCounter::PipeCompileTimeAsync,    async.compileTime);
     
     std::lock_guard<sync::Spinlock> lock(m_statLock);
     result.merge(m_statCounters);
@@ -207,6 +229,11 @@ namespace dxvk {
   }
 
 
+  DxvkTimeHistogram DxvkDevice::getCompileTimeHistogram(DxvkPipelineCompileType type) const {
+    return m_pipelineManager->getCompileTimes(type).histogram;
+  }
+
+
   uint32_t DxvkDevice::getCurrentFrameId() const {
     return m_statCounters.getCtr(DxvkStatCounter::QueuePresentCount);
   }
@@ -217,8 +244,8 @@ namespace dxvk {
   }
 
 
-  void DxvkDevice::registerShader(const Rc<DxvkShader>& shader) {
-    m_pipelineManager->registerShader(shader);
+  Rc<DxvkShader> DxvkDevice::registerShader(const Rc<DxvkShader>& shader) {
+    return m_pipelineManager->registerShader(shader);
   }
   
   
@@ -19,6 +19,8 @@
 #include "dxvk_renderpass.h"
 #include "dxvk_sampler.h"
 #include "dxvk_shader.h"
+#include "dxvk_shader_cache.h"
+#include "dxvk_shader_stats.h"
 #include "dxvk_stats.h"
 #include "dxvk_unbound.h"
 
@@ -276,6 +278,18 @@ namespace dxvk {
      * usage, draw calls, etc.
      */
     DxvkStatCounters getStatCounters();
+    
+    /**
+     * \brief Retrieves pipeline compile time histogram
+     * 
+     * Can be used by the HUD to show how long
+     * pipeline compiles take on the CS thread
+     * and on the state cache worker threads.
+     * \param [in] type Compile type
+     * \returns Compile time histogram
+     */
+    DxvkTimeHistogram getCompileTimeHistogram(
+            DxvkPipelineCompileType type) const;
 
     /**
      * \brief Retreves current frame ID
@@ -294,11 +308,40 @@ namespace dxvk {
     
     /**
      * \brief Registers a shader
+     * 
+     * The client API must use the returned shader,
+     * which may be an identical shader that was
+     * registered earlier.
      * \param [in] shader Newly compiled shader
+     * \returns The shader to use
      */
-    void registerShader(
+    Rc<DxvkShader> registerShader(
       const Rc<DxvkShader>&         shader);
     
+    /**
+     * \brief Shader cache
+     * 
+     * Can be used by the client API to store
+     * translated shaders across runs.
+     * \returns The shader cache, or \c nullptr
+     *    if the shader cache is disabled
+     */
+    Rc<DxvkShaderCache> shaderCache() const {
+      return m_shaderCache;
+    }
+    
+    /**
+     * \brief Shader statistics
+     * 
+     * Used to record translation and pipeline
+     * compile statistics for individual shaders.
+     * \returns Shader statistics, or \c nullptr
+     *    if shader statistics are disabled
+     */
+    Rc<DxvkShaderStats> shaderStats() const {
+      return m_shaderStats;
+    }
+    
     /**
      * \brief Presents a swap chain image
      * 
@@ -380,7 +423,9 @@ namespace dxvk {
     
     Rc<DxvkMemoryAllocator>     m_memory;
     Rc<DxvkRenderPassPool>      m_renderPassPool;
+    Rc<DxvkShaderStats>         m_shaderStats;
     Rc<DxvkPipelineManager>     m_pipelineManager;
+    Rc<DxvkShaderCache>         m_shaderCache;
 
     Rc<DxvkMetaClearObjects>    m_metaClearObjects;
     Rc<DxvkMetaCopyObjects>     m_metaCopyObjects;
@@ -1,8 +1,10 @@
 #include <chrono>
+#include <cstddef>
 #include <cstring>
 
 #include "dxvk_device.h"
 #include "dxvk_graphics.h"
+#include "dxvk_pipe_predictor.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_spec_const.h"
 #include "dxvk_state_cache.h"
@@ -37,6 +39,12 @@ namespace dxvk {
   }
   
   
+  bool DxvkGraphicsPipelineStateInfo::matchesExceptOutputState(const DxvkGraphicsPipelineStateInfo& other) const {
+    // Depth-stencil and blend state are stored at the end of the struct
+    return std::memcmp(this, &other, offsetof(DxvkGraphicsPipelineStateInfo, dsEnableDepthTest)) == 0;
+  }
+  
+  
   DxvkGraphicsPipeline::DxvkGraphicsPipeline(
           DxvkPipelineManager*      pipeMgr,
     const Rc<DxvkShader>&           vs,
@@ -44,35 +52,42 @@ namespace dxvk {
     const Rc<DxvkShader>&           tes,
     const Rc<DxvkShader>&           gs,
     const Rc<DxvkShader>&           fs)
-  : m_vkd(pipeMgr->m_device->vkd()), m_pipeMgr(pipeMgr) {
-    DxvkDescriptorSlotMapping slotMapping;
-    if (vs  != nullptr) vs ->defineResourceSlots(slotMapping);
-    if (tcs != nullptr) tcs->defineResourceSlots(slotMapping);
-    if (tes != nullptr) tes->defineResourceSlots(slotMapping);
-    if (gs  != nullptr) gs ->defineResourceSlots(slotMapping);
-    if (fs  != nullptr) fs ->defineResourceSlots(slotMapping);
-    
-    slotMapping.makeDescriptorsDynamic(
+  : m_vkd(pipeMgr->m_device->vkd()), m_pipeMgr(pipeMgr),
+    m_vs(vs), m_tcs(tcs), m_tes(tes), m_gs(gs), m_fs(fs) {
+    if (vs  != nullptr) vs ->defineResourceSlots(m_slotMapping);
+    if (tcs != nullptr) tcs->defineResourceSlots(m_slotMapping);
+    if (tes != nullptr) tes->defineResourceSlots(m_slotMapping);
+    if (gs  != nullptr) gs ->defineResourceSlots(m_slotMapping);
+    if (fs  != nullptr) fs ->defineResourceSlots(m_slotMapping);
+    
+    m_slotMapping.makeDescriptorsDynamic(
       pipeMgr->m_device->options().maxNumDynamicUniformBuffers,
       pipeMgr->m_device->options().maxNumDynamicStorageBuffers);
     
     m_layout = new DxvkPipelineLayout(m_vkd,
-      slotMapping.bindingCount(),
-      slotMapping.bindingInfos(),
+      m_slotMapping.bindingCount(),
+      m_slotMapping.bindingInfos(),
+      getPushConstantRange(),
       VK_PIPELINE_BIND_POINT_GRAPHICS);
     
+    // The dual-source blending variant of the fragment
+    // shader is only created when a pipeline needs it
     DxvkShaderModuleCreateInfo moduleInfo;
     moduleInfo.fsDualSrcBlend = false;
+    moduleInfo.outputMask     = ~0u;
     
-    DxvkShaderModuleCreateInfo moduleInfoDualSrc;
-    moduleInfoDualSrc.fsDualSrcBlend = true;
+    // Outputs of the last stage before rasterization
+    // that the fragment shader does not read are unused
+    DxvkShaderModuleCreateInfo lastStageInfo = moduleInfo;
+    lastStageInfo.outputMask = fs != nullptr ? fs->interfaceSlots().inputSlots : 0;
     
-    if (vs  != nullptr) m_vs  = vs ->createShaderModule(m_vkd, slotMapping, moduleInfo);
-    if (tcs != nullptr) m_tcs = tcs->createShaderModule(m_vkd, slotMapping, moduleInfo);
-    if (tes != nullptr) m_tes = tes->createShaderModule(m_vkd, slotMapping, moduleInfo);
-    if (gs  != nullptr) m_gs  = gs ->createShaderModule(m_vkd, slotMapping, moduleInfo);
-    if (fs  != nullptr) m_fs  = fs ->createShaderModule(m_vkd, slotMapping, moduleInfo);
-    if (fs  != nullptr) m_fs2 = fs ->createShaderModule(m_vkd, slotMapping, moduleInfoDualSrc);
+    if (vs  != nullptr) m_vsModule  = vs ->createShaderModule(m_vkd, m_slotMapping,
+      tes == nullptr && gs == nullptr ? lastStageInfo : moduleInfo);
+    if (tcs != nullptr) m_tcsModule = tcs->createShaderModule(m_vkd, m_slotMapping, moduleInfo);
+    if (tes != nullptr) m_tesModule = tes->createShaderModule(m_vkd, m_slotMapping,
+      gs == nullptr ? lastStageInfo : moduleInfo);
+    if (gs  != nullptr) m_gsModule  = gs ->createShaderModule(m_vkd, m_slotMapping, lastStageInfo);
+    if (fs  != nullptr) m_fsModule  = fs ->createShaderModule(m_vkd, m_slotMapping, moduleInfo);
     
     m_vsIn  = vs != nullptr ? vs->interfaceSlots().inputSlots  : 0;
     m_fsOut = fs != nullptr ? fs->interfaceSlots().outputSlots : 0;
@@ -103,15 +118,15 @@ namespace dxvk {
           VkShaderStageFlagBits             stage) const {
     switch (stage) {
       case VK_SHADER_STAGE_VERTEX_BIT:
-        return m_vs != nullptr ? m_vs->shader() : nullptr;
+        return m_vs;
       case VK_SHADER_STAGE_GEOMETRY_BIT:
-        return m_gs != nullptr ? m_gs->shader() : nullptr;
+        return m_gs;
       case VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT:
-        return m_tcs != nullptr ? m_tcs->shader() : nullptr;
+        return m_tcs;
       case VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT:
-        return m_tes != nullptr ? m_tes->shader() : nullptr;
+        return m_tes;
       case VK_SHADER_STAGE_FRAGMENT_BIT:
-        return m_fs != nullptr ? m_fs->shader() : nullptr;
+        return m_fs;
       default:
         return nullptr;
     }
@@ -123,43 +138,63 @@ namespace dxvk {
     const DxvkRenderPass&                renderPass) {
     VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
     
-    VkPipeline newPipelineHandle = VK_NULL_HANDLE;
+    VkPipeline pipelineHandle = VK_NULL_HANDLE;
 
     { std::lock_guard<sync::Spinlock> lock(m_mutex);
     
       auto instance = this->findInstance(state, renderPassHandle);
       
-      if (instance != nullptr)
-        return instance->pipeline();
-    
-      // If the pipeline state vector is invalid, don't try
-      // to create a new pipeline, it won't work anyway.
-      if (!this->validatePipelineState(state))
-        return VK_NULL_HANDLE;
-      
-      // If no pipeline instance exists with the given state
-      // vector, create a new one and add it to the list.
-      newPipelineHandle = this->compilePipeline(state, renderPassHandle, m_basePipeline);
+      if (instance == nullptr) {
+        // If the pipeline state vector is invalid, don't try
+        // to create a new pipeline, it won't work anyway.
+        if (!this->validatePipelineState(state))
+          return VK_NULL_HANDLE;
+        
+        // Let the state cache workers compile other state
+        // vectors for this shader set as soon as possible
+        this->promotePipelineInCache();
+
+        // If no pipeline instance exists with the given state
+        // vector, create a new one and add it to the list.
+        instance = this->createInstance(state, renderPassHandle,
+          DxvkPipelineCompileType::Sync);
+      }
 
-      // Add new pipeline to the set
-      m_pipelines.emplace_back(state, renderPassHandle, newPipelineHandle);
-      m_pipeMgr->m_numGraphicsPipelines += 1;
+      if (instance->isUsed())
+        return instance->pipeline();
       
-      if (!m_basePipeline && newPipelineHandle)
-        m_basePipeline = newPipelineHandle;
+      instance->setUsed();
+      pipelineHandle = instance->pipeline();
     }
     
-    if (newPipelineHandle != VK_NULL_HANDLE)
+    // Also covers pipelines compiled by the state cache, so
+    // that it can keep track of which pipelines are in use
+    if (pipelineHandle != VK_NULL_HANDLE) {
       this->writePipelineStateToCache(state, renderPass.format());
+      this->addPipelineToPredictor(state, renderPass.format());
+    }
     
-    return newPipelineHandle;
+    return pipelineHandle;
   }
   
   
-  const DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
+  void DxvkGraphicsPipeline::compilePipeline(
     const DxvkGraphicsPipelineStateInfo& state,
-          VkRenderPass                   renderPass) const {
-    for (const auto& instance : m_pipelines) {
+    const DxvkRenderPass&                renderPass) {
+    VkRenderPass renderPassHandle = renderPass.getDefaultHandle();
+    
+    std::lock_guard<sync::Spinlock> lock(m_mutex);
+
+    if (this->findInstance(state, renderPassHandle) == nullptr
+     && this->validatePipelineState(state))
+      this->createInstance(state, renderPassHandle, DxvkPipelineCompileType::Async);
+  }
+  
+  
+  DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::findInstance(
+    const DxvkGraphicsPipelineStateInfo& state,
+          VkRenderPass                   renderPass) {
+    for (auto& instance : m_pipelines) {
       if (instance.isCompatible(state, renderPass))
         return &instance;
     }
@@ -168,10 +203,39 @@ namespace dxvk {
   }
   
   
-  VkPipeline DxvkGraphicsPipeline::compilePipeline(
+  DxvkGraphicsPipelineInstance* DxvkGraphicsPipeline::createInstance(
     const DxvkGraphicsPipelineStateInfo& state,
           VkRenderPass                   renderPass,
-          VkPipeline                     baseHandle) const {
+          DxvkPipelineCompileType        type) {
+    VkPipeline newPipelineHandle = this->createPipeline(
+      state, renderPass, this->findBasePipeline(state), type);
+    
+    // Add new pipeline to the set
+    m_pipelines.emplace_back(state, renderPass, newPipelineHandle);
+    m_pipeMgr->m_numGraphicsPipelines += 1;
+    return &m_pipelines.back();
+  }
+  
+  
+  VkPipeline DxvkGraphicsPipeline::findBasePipeline(
+    const DxvkGraphicsPipelineStateInfo& state) const {
+    // Render pass compatibility does not matter here since
+    // render passes only affect output state. If no similar
+    // pipeline exists, a derivative would not help anyway.
+    for (const auto& instance : m_pipelines) {
+      if (instance.isDerivativeCompatible(state))
+        return instance.pipeline();
+    }
+    
+    return VK_NULL_HANDLE;
+  }
+  
+  
+  VkPipeline DxvkGraphicsPipeline::createPipeline(
+    const DxvkGraphicsPipelineStateInfo& state,
+          VkRenderPass                   renderPass,
+          VkPipeline                     baseHandle,
+          DxvkPipelineCompileType        type) const {
     if (Logger::logLevel() <= LogLevel::Debug) {
       Logger::debug("Compiling graphics pipeline...");
       this->logPipelineState(LogLevel::Debug, state);
@@ -204,6 +268,7 @@ namespace dxvk {
     // Set up some specialization constants
     DxvkSpecConstantData specData;
     specData.rasterizerSampleCount = uint32_t(sampleCount);
+    specData.pushConstantStage     = uint32_t(m_layout->pushConstantRange().stage);
     
     for (uint32_t i = 0; i < MaxNumActiveBindings; i++)
       specData.activeBindings[i] = state.bsBindingMask.isBound(i) ? VK_TRUE : VK_FALSE;
@@ -222,13 +287,22 @@ namespace dxvk {
       util::isDualSourceBlendFactor(state.omBlendAttachments[0].srcAlphaBlendFactor) ||
       util::isDualSourceBlendFactor(state.omBlendAttachments[0].dstAlphaBlendFactor));
 
-    Rc<DxvkShaderModule> fs = useDualSrcBlend ? m_fs2 : m_fs;
+    Rc<DxvkShaderModule> fs = m_fsModule;
 
-    if (m_vs  != nullptr) stages.push_back(m_vs->stageInfo(&specInfo));
-    if (m_tcs != nullptr) stages.push_back(m_tcs->stageInfo(&specInfo));
-    if (m_tes != nullptr) stages.push_back(m_tes->stageInfo(&specInfo));
-    if (m_gs  != nullptr) stages.push_back(m_gs->stageInfo(&specInfo));
-    if (fs    != nullptr) stages.push_back(fs->stageInfo(&specInfo));
+    if (m_fs != nullptr && useDualSrcBlend) {
+      DxvkShaderModuleCreateInfo moduleInfo;
+      moduleInfo.fsDualSrcBlend = true;
+      moduleInfo.outputMask     = ~0u;
+
+      // Looked up in the shader's module cache after the first use
+      fs = m_fs->createShaderModule(m_vkd, m_slotMapping, moduleInfo);
+    }
+
+    if (m_vsModule  != nullptr) stages.push_back(m_vsModule ->stageInfo(&specInfo));
+    if (m_tcsModule != nullptr) stages.push_back(m_tcsModule->stageInfo(&specInfo));
+    if (m_tesModule != nullptr) stages.push_back(m_tesModule->stageInfo(&specInfo));
+    if (m_gsModule  != nullptr) stages.push_back(m_gsModule ->stageInfo(&specInfo));
+    if (fs          != nullptr) stages.push_back(fs->stageInfo(&specInfo));
 
     // Fix up color write masks using the component mappings
     std::array<VkPipelineColorBlendAttachmentState, MaxNumRenderTargets> omBlendAttachments;
@@ -262,7 +336,7 @@ namespace dxvk {
     }
 
     int32_t rasterizedStream = m_gs != nullptr
-      ? m_gs->shader()->shaderOptions().rasterizedStream
+      ? m_gs->shaderOptions().rasterizedStream
       : 0;
 
     VkPipelineVertexInputDivisorStateCreateInfoEXT viDivisorInfo;
@@ -398,9 +472,12 @@ namespace dxvk {
     info.basePipelineHandle       = baseHandle;
     info.basePipelineIndex        = -1;
     
-    info.flags |= baseHandle == VK_NULL_HANDLE
-      ? VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT
-      : VK_PIPELINE_CREATE_DERIVATIVE_BIT;
+    // Every pipeline may serve as a base for pipelines
+    // that only differ in output state or render pass
+    info.flags |= VK_PIPELINE_CREATE_ALLOW_DERIVATIVES_BIT;
+    
+    if (baseHandle != VK_NULL_HANDLE)
+      info.flags |= VK_PIPELINE_CREATE_DERIVATIVE_BIT;
     
     if (tsInfo.patchControlPoints == 0)
       info.pTessellationState = nullptr;
@@ -417,8 +494,37 @@ namespace dxvk {
     }
     
     auto t1 = std::chrono::high_resolution_clock::now();
-    auto td = std::chrono::duration_cast<std::chrono::milliseconds>(t1 - t0);
-    Logger::debug(str::format("DxvkGraphicsPipeline: Finished in ", td.count(), " ms"));
+    auto td = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0);
+
+    // Keep track of how long each compile strategy takes
+    if (baseHandle != VK_NULL_HANDLE) {
+      m_pipeMgr->m_numDerivedPipelines += 1;
+      m_pipeMgr->m_derivedCompileTime  += td.count();
+    } else {
+      m_pipeMgr->m_numFullPipelines    += 1;
+      m_pipeMgr->m_fullCompileTime     += td.count();
+    }
+
+    Logger::debug(str::format("DxvkGraphicsPipeline: Finished in ", td.count() / 1000, " ms",
+      baseHandle != VK_NULL_HANDLE ? " (derivative)" : ""));
+    
+    Rc<DxvkShaderStats> shaderStats = m_pipeMgr->m_device->shaderStats();
+
+    if (shaderStats != nullptr) {
+      for (const auto& shader : { m_vs, m_tcs, m_tes, m_gs, m_fs }) {
+        if (shader != nullptr)
+          shaderStats->addPipeline(shader->getShaderKey(), td.count());
+      }
+    }
+    
+    // Attribute slow compiles to the shaders involved so
+    // that stutter can be traced back to specific shaders
+    if (m_pipeMgr->recordCompileTime(type, td.count())) {
+      Logger::info(str::format("DxvkGraphicsPipeline: Slow ",
+        type == DxvkPipelineCompileType::Sync ? "on-demand" : "background",
+        " compile took ", td.count() / 1000, " ms"));
+      this->logPipelineState(LogLevel::Info, state);
+    }
     return pipeline;
   }
   
@@ -455,31 +561,86 @@ namespace dxvk {
   }
   
   
-  void DxvkGraphicsPipeline::writePipelineStateToCache(
-    const DxvkGraphicsPipelineStateInfo& state,
-    const DxvkRenderPassFormat&          format) const {
-    if (m_pipeMgr->m_stateCache == nullptr)
-      return;
-    
+  DxvkStateCacheKey DxvkGraphicsPipeline::getStateCacheKey() const {
     DxvkStateCacheKey key;
     if (m_vs  != nullptr) key.vs = m_vs->getShaderKey();
     if (m_tcs != nullptr) key.tcs = m_tcs->getShaderKey();
     if (m_tes != nullptr) key.tes = m_tes->getShaderKey();
     if (m_gs  != nullptr) key.gs = m_gs->getShaderKey();
     if (m_fs  != nullptr) key.fs = m_fs->getShaderKey();
+    return key;
+  }
+
+
+  DxvkPushConstantRange DxvkGraphicsPipeline::getPushConstantRange() const {
+    DxvkPushConstantRange range = { 0, VkShaderStageFlagBits(0), 0, 0 };
+
+    // Push constant space is too small to be shared, so the
+    // first stage that can use it gets to own it. Other stages
+    // still have to declare the range, but their shaders will
+    // read the constant buffer through the descriptor instead.
+    for (const auto& shader : { m_vs, m_tcs, m_tes, m_gs, m_fs }) {
+      if (shader == nullptr)
+        continue;
+      
+      DxvkShaderOptions options = shader->shaderOptions();
+
+      if (!options.pushConstSize)
+        continue;
+      
+      if (!range.stage) {
+        range.slot  = options.pushConstSlot;
+        range.stage = shader->stage();
+      }
+
+      range.stages |= shader->stage();
+      range.size    = std::max(range.size, options.pushConstSize);
+    }
+
+    return range;
+  }
+
 
-    m_pipeMgr->m_stateCache->addGraphicsPipeline(key, state, format);
+  void DxvkGraphicsPipeline::promotePipelineInCache() const {
+    if (m_pipeMgr->m_stateCache == nullptr)
+      return;
+    
+    m_pipeMgr->m_stateCache->promotePipeline(getStateCacheKey());
+  }
+
+
+  void DxvkGraphicsPipeline::writePipelineStateToCache(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPassFormat&          format) const {
+    if (m_pipeMgr->m_stateCache == nullptr)
+      return;
+    
+    m_pipeMgr->m_stateCache->addGraphicsPipeline(
+      getStateCacheKey(), state, format);
+  }
+  
+  
+  void DxvkGraphicsPipeline::addPipelineToPredictor(
+    const DxvkGraphicsPipelineStateInfo& state,
+    const DxvkRenderPassFormat&          format) const {
+    if (m_pipeMgr->m_predictor == nullptr)
+      return;
+    
+    if (m_tcs != nullptr || m_tes != nullptr || m_gs != nullptr)
+      return;
+    
+    m_pipeMgr->m_predictor->addPipeline(m_vs, state, format);
   }
   
   
   void DxvkGraphicsPipeline::logPipelineState(
           LogLevel                       level,
     const DxvkGraphicsPipelineStateInfo& state) const {
-    if (m_vs  != nullptr) Logger::log(level, str::format("  vs  : ", m_vs ->shader()->debugName()));
-    if (m_tcs != nullptr) Logger::log(level, str::format("  tcs : ", m_tcs->shader()->debugName()));
-    if (m_tes != nullptr) Logger::log(level, str::format("  tes : ", m_tes->shader()->debugName()));
-    if (m_gs  != nullptr) Logger::log(level, str::format("  gs  : ", m_gs ->shader()->debugName()));
-    if (m_fs  != nullptr) Logger::log(level, str::format("  fs  : ", m_fs ->shader()->debugName()));
+    if (m_vs  != nullptr) Logger::log(level, str::format("  vs  : ", m_vs ->debugName()));
+    if (m_tcs != nullptr) Logger::log(level, str::format("  tcs : ", m_tcs->debugName()));
+    if (m_tes != nullptr) Logger::log(level, str::format("  tes : ", m_tes->debugName()));
+    if (m_gs  != nullptr) Logger::log(level, str::format("  gs  : ", m_gs ->debugName()));
+    if (m_fs  != nullptr) Logger::log(level, str::format("  fs  : ", m_fs ->debugName()));
     
     // TODO log more pipeline state
   }
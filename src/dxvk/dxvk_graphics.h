@@ -15,6 +15,7 @@ namespace dxvk {
   
   class DxvkDevice;
   class DxvkPipelineManager;
+  struct DxvkStateCacheKey;
 
   /**
    * \brief Flags that describe pipeline properties
@@ -47,6 +48,17 @@ namespace dxvk {
     bool operator == (const DxvkGraphicsPipelineStateInfo& other) const;
     bool operator != (const DxvkGraphicsPipelineStateInfo& other) const;
 
+    /**
+     * \brief Checks whether only output state differs
+     * 
+     * Output state includes depth-stencil and blend
+     * state. Pipelines that differ only in output
+     * state are good candidates for derivatives.
+     * \param [in] other State vector to compare to
+     * \returns \c true if all other state is equal
+     */
+    bool matchesExceptOutputState(const DxvkGraphicsPipelineStateInfo& other) const;
+
     bool useDynamicStencilRef() const {
       return dsEnableStencilTest;
     }
@@ -153,6 +165,20 @@ namespace dxvk {
           && m_renderPass  == rp;
     }
 
+    /**
+     * \brief Checks whether the instance can serve as a base
+     * 
+     * Pipelines that only differ in output state or render
+     * pass are created as derivatives of one another.
+     * \param [in] state Graphics pipeline state
+     * \returns \c true if the pipeline can be used as a base
+     */
+    bool isDerivativeCompatible(
+      const DxvkGraphicsPipelineStateInfo&  state) const {
+      return m_pipeline != VK_NULL_HANDLE
+          && m_stateVector.matchesExceptOutputState(state);
+    }
+
     /**
      * \brief Retrieves pipeline
      * \returns The pipeline handle
@@ -161,11 +187,31 @@ namespace dxvk {
       return m_pipeline;
     }
 
+    /**
+     * \brief Checks whether the pipeline has been used
+     * 
+     * Pipelines compiled by the state cache are
+     * not considered used until the application
+     * requests them for the first time.
+     * \returns \c true if the pipeline was used
+     */
+    bool isUsed() const {
+      return m_used;
+    }
+
+    /**
+     * \brief Marks the pipeline as used
+     */
+    void setUsed() {
+      m_used = true;
+    }
+
   private:
 
     DxvkGraphicsPipelineStateInfo m_stateVector;
     VkRenderPass                  m_renderPass;
     VkPipeline                    m_pipeline;
+    bool                          m_used = false;
 
   };
 
@@ -234,6 +280,20 @@ namespace dxvk {
       const DxvkGraphicsPipelineStateInfo&    state,
       const DxvkRenderPass&                   renderPass);
     
+    /**
+     * \brief Compiles a pipeline
+     * 
+     * Compiles the given pipeline ahead of time and
+     * stores the result for future use. Used by the
+     * state cache, this does not count as a use of
+     * the pipeline by the application.
+     * \param [in] state Pipeline state vector
+     * \param [in] renderPass The render pass
+     */
+    void compilePipeline(
+      const DxvkGraphicsPipelineStateInfo&    state,
+      const DxvkRenderPass&                   renderPass);
+    
   private:
     
     struct PipelineStruct {
@@ -245,13 +305,20 @@ namespace dxvk {
     Rc<vk::DeviceFn>        m_vkd;
     DxvkPipelineManager*    m_pipeMgr;
 
+    Rc<DxvkShader>          m_vs;
+    Rc<DxvkShader>          m_tcs;
+    Rc<DxvkShader>          m_tes;
+    Rc<DxvkShader>          m_gs;
+    Rc<DxvkShader>          m_fs;
+
+    DxvkDescriptorSlotMapping m_slotMapping;
     Rc<DxvkPipelineLayout>  m_layout;
-    Rc<DxvkShaderModule>    m_vs;
-    Rc<DxvkShaderModule>    m_tcs;
-    Rc<DxvkShaderModule>    m_tes;
-    Rc<DxvkShaderModule>    m_gs;
-    Rc<DxvkShaderModule>    m_fs;
-    Rc<DxvkShaderModule>    m_fs2;
+
+    Rc<DxvkShaderModule>    m_vsModule;
+    Rc<DxvkShaderModule>    m_tcsModule;
+    Rc<DxvkShaderModule>    m_tesModule;
+    Rc<DxvkShaderModule>    m_gsModule;
+    Rc<DxvkShaderModule>    m_fsModule;
     
     uint32_t m_vsIn  = 0;
     uint32_t m_fsOut = 0;
@@ -263,17 +330,23 @@ namespace dxvk {
     alignas(CACHE_LINE_SIZE) sync::Spinlock   m_mutex;
     std::vector<DxvkGraphicsPipelineInstance> m_pipelines;
     
-    // Pipeline handles used for derivative pipelines
-    VkPipeline m_basePipeline = VK_NULL_HANDLE;
+    DxvkGraphicsPipelineInstance* findInstance(
+      const DxvkGraphicsPipelineStateInfo& state,
+            VkRenderPass                   renderPass);
     
-    const DxvkGraphicsPipelineInstance* findInstance(
+    DxvkGraphicsPipelineInstance* createInstance(
       const DxvkGraphicsPipelineStateInfo& state,
-            VkRenderPass                   renderPass) const;
+            VkRenderPass                   renderPass,
+            DxvkPipelineCompileType        type);
+    
+    VkPipeline findBasePipeline(
+      const DxvkGraphicsPipelineStateInfo& state) const;
     
-    VkPipeline compilePipeline(
+    VkPipeline createPipeline(
       const DxvkGraphicsPipelineStateInfo& state,
             VkRenderPass                   renderPass,
-            VkPipeline                     baseHandle) const;
+            VkPipeline                     baseHandle,
+            DxvkPipelineCompileType        type) const;
     
     void destroyPipeline(
             VkPipeline                     pipeline) const;
@@ -281,10 +354,20 @@ namespace dxvk {
     bool validatePipelineState(
       const DxvkGraphicsPipelineStateInfo& state) const;
     
+    DxvkStateCacheKey getStateCacheKey() const;
+
+    DxvkPushConstantRange getPushConstantRange() const;
+
+    void promotePipelineInCache() const;
+
     void writePipelineStateToCache(
       const DxvkGraphicsPipelineStateInfo& state,
       const DxvkRenderPassFormat&          format) const;
     
+    void addPipelineToPredictor(
+      const DxvkGraphicsPipelineStateInfo& state,
+      const DxvkRenderPassFormat&          format) const;
+    
     void logPipelineState(
             LogLevel                       level,
       const DxvkGraphicsPipelineStateInfo& state) const;
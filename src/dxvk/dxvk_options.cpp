@@ -3,11 +3,16 @@
 namespace dxvk {
 
   DxvkOptions::DxvkOptions(const Config& config) {
-    allowMemoryOvercommit = config.getOption<bool>    ("dxvk.allowMemoryOvercommit",  false);
-    enableStateCache      = config.getOption<bool>    ("dxvk.enableStateCache",       true);
-    numCompilerThreads    = config.getOption<int32_t> ("dxvk.numCompilerThreads",     0);
-    useRawSsbo            = config.getOption<Tristate>("dxvk.useRawSsbo",             Tristate::Auto);
-    useEarlyDiscard       = config.getOption<Tristate>("dxvk.useEarlyDiscard",        Tristate::Auto);
+    allowMemoryOvercommit    = config.getOption<bool>    ("dxvk.allowMemoryOvercommit",     false);
+    enableStateCache         = config.getOption<bool>    ("dxvk.enableStateCache",          true);
+    enableShaderCache        = config.getOption<bool>    ("dxvk.enableShaderCache",         true);
+    enablePipelinePrediction = config.getOption<bool>    ("dxvk.enablePipelinePrediction",  true);
+    numCompilerThreads       = config.getOption<int32_t> ("dxvk.numCompilerThreads",        0);
+    slowCompileThreshold     = config.getOption<int32_t> ("dxvk.slowCompileThreshold",      20);
+    useRawSsbo               = config.getOption<Tristate>("dxvk.useRawSsbo",                Tristate::Auto);
+    useEarlyDiscard          = config.getOption<Tristate>("dxvk.useEarlyDiscard",           Tristate::Auto);
+    useSubgroupAtomics       = config.getOption<Tristate>("dxvk.useSubgroupAtomics",        Tristate::Auto);
+    usePushConstants         = config.getOption<Tristate>("dxvk.usePushConstants",          Tristate::Auto);
   }
 
 }
\ No newline at end of file
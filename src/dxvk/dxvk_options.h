@@ -15,13 +15,26 @@ namespace dxvk {
     /// Enable state cache
     bool enableStateCache;
 
+    /// Enable shader cache
+    bool enableShaderCache;
+
+    /// Compile pipelines for newly
+    /// created shaders speculatively
+    bool enablePipelinePrediction;
+
     /// Number of compiler threads
     /// when using the state cache
     int32_t numCompilerThreads;
 
+    /// Pipeline compile time, in milliseconds,
+    /// above which the shaders get logged
+    int32_t slowCompileThreshold;
+
     /// Shader-related options
     Tristate useRawSsbo;
     Tristate useEarlyDiscard;
+    Tristate useSubgroupAtomics;
+    Tristate usePushConstants;
   };
 
 }
\ No newline at end of file
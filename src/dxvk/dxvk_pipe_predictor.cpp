@@ -0,0 +1,203 @@
+#include <algorithm>
+
+#include "dxvk_pipe_predictor.h"
+#include "dxvk_pipemanager.h"
+
+namespace dxvk {
+
+  DxvkPipelinePredictor::DxvkPipelinePredictor(
+          DxvkPipelineManager*  pipeManager,
+          DxvkRenderPassPool*   passManager)
+  : m_pipeManager(pipeManager),
+    m_passManager(passManager) {
+    m_workerThread = dxvk::thread([this] () { workerFunc(); });
+    m_workerThread.set_priority(ThreadPriority::Lowest);
+  }
+
+
+  DxvkPipelinePredictor::~DxvkPipelinePredictor() {
+    { std::lock_guard<std::mutex> lock(m_workerLock);
+      m_stopThread.store(true);
+      m_workerCond.notify_all();
+    }
+
+    m_workerThread.join();
+  }
+
+
+  void DxvkPipelinePredictor::registerShader(
+    const Rc<DxvkShader>&                 shader) {
+    VkShaderStageFlagBits stage = shader->stage();
+
+    if (stage != VK_SHADER_STAGE_VERTEX_BIT
+     && stage != VK_SHADER_STAGE_FRAGMENT_BIT)
+      return;
+
+    std::vector<DxvkPipelinePrediction> predictions;
+
+    { std::lock_guard<std::mutex> lock(m_mutex);
+
+      // Most recently created shaders are the most
+      // likely partners, so they are checked first
+      if (stage == VK_SHADER_STAGE_VERTEX_BIT) {
+        for (auto fs = m_recentFs.rbegin(); fs != m_recentFs.rend(); fs++)
+          this->predictPipelines(shader, *fs, predictions);
+
+        m_recentVs.push_back(shader);
+
+        if (m_recentVs.size() > MaxRecentShaders)
+          m_recentVs.pop_front();
+      } else {
+        for (auto vs = m_recentVs.rbegin(); vs != m_recentVs.rend(); vs++)
+          this->predictPipelines(*vs, shader, predictions);
+
+        m_recentFs.push_back(shader);
+
+        if (m_recentFs.size() > MaxRecentShaders)
+          m_recentFs.pop_front();
+      }
+    }
+
+    if (predictions.empty())
+      return;
+
+    std::lock_guard<std::mutex> lock(m_workerLock);
+
+    for (auto& p : predictions) {
+      if (m_workerQueue.size() >= MaxQueuedPredictions)
+        break;
+
+      m_workerQueue.push_back(std::move(p));
+    }
+
+    m_workerCond.notify_one();
+  }
+
+
+  void DxvkPipelinePredictor::addPipeline(
+    const Rc<DxvkShader>&                 vs,
+    const DxvkGraphicsPipelineStateInfo&  state,
+    const DxvkRenderPassFormat&           format) {
+    DxvkPipelineObservation observation;
+    observation.vsInputSlots = vs->interfaceSlots().inputSlots;
+    observation.state        = state;
+    observation.format       = format;
+    observation.useCount     = 1;
+
+    observation.state.bsBindingMask.clear();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (auto& o : m_observations) {
+      if (o.vsInputSlots == observation.vsInputSlots
+       && o.state        == observation.state
+       && o.format.matches(observation.format)) {
+        o.useCount += 1;
+        return;
+      }
+    }
+
+    if (m_observations.size() < MaxObservations) {
+      m_observations.push_back(observation);
+      return;
+    }
+
+    // Replace the least frequently used state vector
+    auto entry = std::min_element(m_observations.begin(), m_observations.end(),
+      [] (const DxvkPipelineObservation& a, const DxvkPipelineObservation& b) {
+        return a.useCount < b.useCount;
+      });
+
+    *entry = observation;
+  }
+
+
+  void DxvkPipelinePredictor::predictPipelines(
+    const Rc<DxvkShader>&                 vs,
+    const Rc<DxvkShader>&                 fs,
+          std::vector<DxvkPipelinePrediction>& predictions) const {
+    if (predictions.size() >= MaxPredictionsPerShader || !isCompatible(vs, fs))
+      return;
+
+    // The vertex input state must provide all inputs
+    // that the vertex shader consumes, so only state
+    // vectors used with the same signature are useful
+    std::vector<const DxvkPipelineObservation*> candidates;
+
+    for (const auto& o : m_observations) {
+      if (o.vsInputSlots == vs->interfaceSlots().inputSlots)
+        candidates.push_back(&o);
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(),
+      [] (const DxvkPipelineObservation* a, const DxvkPipelineObservation* b) {
+        return a->useCount > b->useCount;
+      });
+
+    for (const auto* o : candidates) {
+      if (predictions.size() >= MaxPredictionsPerShader)
+        break;
+
+      DxvkPipelinePrediction prediction;
+      prediction.vs     = vs;
+      prediction.fs     = fs;
+      prediction.state  = o->state;
+      prediction.format = o->format;
+
+      predictions.push_back(std::move(prediction));
+    }
+  }
+
+
+  void DxvkPipelinePredictor::compilePipeline(
+    const DxvkPipelinePrediction&         prediction) {
+    auto pipeline = m_pipeManager->createGraphicsPipeline(
+      prediction.vs, nullptr, nullptr, nullptr, prediction.fs);
+
+    // Assume that the application binds all resources that
+    // the shaders use, which is true in the common case
+    DxvkGraphicsPipelineStateInfo state = prediction.state;
+
+    for (uint32_t i = 0; i < pipeline->layout()->bindingCount(); i++)
+      state.bsBindingMask.setBound(i);
+
+    auto rp = m_passManager->getRenderPass(prediction.format);
+    pipeline->compilePipeline(state, *rp);
+  }
+
+
+  void DxvkPipelinePredictor::workerFunc() {
+    env::setThreadName("dxvk-predict");
+
+    while (!m_stopThread.load()) {
+      DxvkPipelinePrediction prediction;
+
+      { std::unique_lock<std::mutex> lock(m_workerLock);
+
+        m_workerCond.wait(lock, [this] () {
+          return m_workerQueue.size()
+              || m_stopThread.load();
+        });
+
+        if (m_workerQueue.size() == 0)
+          break;
+
+        prediction = std::move(m_workerQueue.front());
+        m_workerQueue.pop_front();
+      }
+
+      compilePipeline(prediction);
+    }
+  }
+
+
+  bool DxvkPipelinePredictor::isCompatible(
+    const Rc<DxvkShader>&                 vs,
+    const Rc<DxvkShader>&                 fs) {
+    uint32_t vsOutputs = vs->interfaceSlots().outputSlots;
+    uint32_t fsInputs  = fs->interfaceSlots().inputSlots;
+
+    return (fsInputs & vsOutputs) == fsInputs;
+  }
+
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include "dxvk_graphics.h"
+#include "dxvk_renderpass.h"
+
+namespace dxvk {
+
+  class DxvkPipelineManager;
+
+  /**
+   * \brief Observed pipeline state
+   *
+   * A state vector that the application has used
+   * with vertex shaders of a given input signature.
+   * The binding mask is ignored since it depends on
+   * the pipeline layout.
+   */
+  struct DxvkPipelineObservation {
+    uint32_t                      vsInputSlots;
+    DxvkGraphicsPipelineStateInfo state;
+    DxvkRenderPassFormat          format;
+    uint32_t                      useCount;
+  };
+
+
+  /**
+   * \brief Predicted pipeline
+   */
+  struct DxvkPipelinePrediction {
+    Rc<DxvkShader>                vs;
+    Rc<DxvkShader>                fs;
+    DxvkGraphicsPipelineStateInfo state;
+    DxvkRenderPassFormat          format;
+  };
+
+
+  /**
+   * \brief Pipeline predictor
+   *
+   * Speculatively compiles pipelines for newly created
+   * shaders. Each new vertex or fragment shader is paired
+   * with recently created shaders of the other stage if
+   * their interfaces match, and compiled with the state
+   * vectors most frequently used by the application so
+   * far with a compatible vertex input signature.
+   *
+   * This is meant to reduce stutter on the first run of
+   * an application, when the state cache is still empty.
+   * Pipelines using tessellation or geometry shaders are
+   * not predicted. Pipelines are compiled on a single
+   * low-priority thread, and predictions are dropped if
+   * that thread cannot keep up.
+   */
+  class DxvkPipelinePredictor : public RcObject {
+
+  public:
+
+    DxvkPipelinePredictor(
+            DxvkPipelineManager*  pipeManager,
+            DxvkRenderPassPool*   passManager);
+
+    ~DxvkPipelinePredictor();
+
+    /**
+     * \brief Registers a newly created shader
+     *
+     * Queues pipelines for this shader and any
+     * recently created partner shaders.
+     * \param [in] shader The shader
+     */
+    void registerShader(
+      const Rc<DxvkShader>&                 shader);
+
+    /**
+     * \brief Records a pipeline used by the application
+     *
+     * \param [in] vs Vertex shader
+     * \param [in] state Pipeline state vector
+     * \param [in] format Render pass format
+     */
+    void addPipeline(
+      const Rc<DxvkShader>&                 vs,
+      const DxvkGraphicsPipelineStateInfo&  state,
+      const DxvkRenderPassFormat&           format);
+
+  private:
+
+    /// Number of recent shaders per stage to pair new shaders with
+    constexpr static uint32_t MaxRecentShaders        = 8;
+    /// Number of distinct state vectors to keep track of
+    constexpr static uint32_t MaxObservations         = 64;
+    /// Number of pipelines to predict for each new shader
+    constexpr static uint32_t MaxPredictionsPerShader = 4;
+    /// Number of queued pipelines after which predictions are dropped
+    constexpr static uint32_t MaxQueuedPredictions    = 256;
+
+    DxvkPipelineManager*                  m_pipeManager;
+    DxvkRenderPassPool*                   m_passManager;
+
+    std::mutex                            m_mutex;
+    std::deque<Rc<DxvkShader>>            m_recentVs;
+    std::deque<Rc<DxvkShader>>            m_recentFs;
+    std::vector<DxvkPipelineObservation>  m_observations;
+
+    std::atomic<bool>                     m_stopThread = { false };
+    std::mutex                            m_workerLock;
+    std::condition_variable               m_workerCond;
+    std::deque<DxvkPipelinePrediction>    m_workerQueue;
+    dxvk::thread                          m_workerThread;
+
+    void predictPipelines(
+      const Rc<DxvkShader>&                 vs,
+      const Rc<DxvkShader>&                 fs,
+            std::vector<DxvkPipelinePrediction>& predictions) const;
+
+    void compilePipeline(
+      const DxvkPipelinePrediction&         prediction);
+
+    void workerFunc();
+
+    static bool isCompatible(
+      const Rc<DxvkShader>&                 vs,
+      const Rc<DxvkShader>&                 fs);
+
+  };
+
+}
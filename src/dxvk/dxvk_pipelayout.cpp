@@ -81,8 +81,10 @@ namespace dxvk {
     const Rc<vk::DeviceFn>&   vkd,
           uint32_t            bindingCount,
     const DxvkDescriptorSlot* bindingInfos,
+    const DxvkPushConstantRange& pushConstants,
           VkPipelineBindPoint pipelineBindPoint)
-  : m_vkd(vkd), m_bindingSlots(bindingCount) {
+  : m_vkd(vkd), m_bindingSlots(bindingCount),
+    m_pushConstants(pushConstants) {
     
     for (uint32_t i = 0; i < bindingCount; i++)
       m_bindingSlots[i] = bindingInfos[i];
@@ -127,14 +129,19 @@ namespace dxvk {
     }
     
     // Create pipeline layout with the given descriptor set layout
+    VkPushConstantRange pushRange;
+    pushRange.stageFlags = pushConstants.stages;
+    pushRange.offset     = 0;
+    pushRange.size       = pushConstants.size;
+
     VkPipelineLayoutCreateInfo pipeInfo;
     pipeInfo.sType                  = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
     pipeInfo.pNext                  = nullptr;
     pipeInfo.flags                  = 0;
     pipeInfo.setLayoutCount         = bindingCount > 0 ? 1 : 0;
     pipeInfo.pSetLayouts            = &m_descriptorSetLayout;
-    pipeInfo.pushConstantRangeCount = 0;
-    pipeInfo.pPushConstantRanges    = nullptr;
+    pipeInfo.pushConstantRangeCount = pushConstants.stages ? 1 : 0;
+    pipeInfo.pPushConstantRanges    = &pushRange;
     
     if (m_vkd->vkCreatePipelineLayout(m_vkd->device(),
         &pipeInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS) {
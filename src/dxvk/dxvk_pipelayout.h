@@ -34,6 +34,22 @@ namespace dxvk {
     VkAccessFlags      access;  ///< Access flags
   };
   
+  /**
+   * \brief Push constant range
+   * 
+   * Describes the constant buffer that is passed to
+   * the pipeline via push constants. Only one stage
+   * can own the push constant data, but all stages
+   * which declare a push constant block must be
+   * included in the stage mask.
+   */
+  struct DxvkPushConstantRange {
+    uint32_t              slot;   ///< Resource slot of the constant buffer
+    VkShaderStageFlagBits stage;  ///< Stage that reads the push data
+    VkShaderStageFlags    stages; ///< Stages declaring push constants
+    uint32_t              size;   ///< Size of the push data, in bytes
+  };
+  
   
   /**
    * \brief Descriptor slot mapping
@@ -137,6 +153,7 @@ namespace dxvk {
       const Rc<vk::DeviceFn>&   vkd,
             uint32_t            bindingCount,
       const DxvkDescriptorSlot* bindingInfos,
+      const DxvkPushConstantRange& pushConstants,
             VkPipelineBindPoint pipelineBindPoint);
     
     ~DxvkPipelineLayout();
@@ -191,6 +208,17 @@ namespace dxvk {
       return m_descriptorTemplate;
     }
 
+    /**
+     * \brief Push constant range
+     * 
+     * If the stage mask is zero, the pipeline
+     * does not use push constants at all.
+     * \returns Push constant range
+     */
+    const DxvkPushConstantRange& pushConstantRange() const {
+      return m_pushConstants;
+    }
+
     /**
      * \brief Number of dynamic bindings
      * \returns Dynamic binding count
@@ -252,6 +280,8 @@ namespace dxvk {
     std::vector<DxvkDescriptorSlot> m_bindingSlots;
     std::vector<uint32_t>           m_dynamicSlots;
 
+    DxvkPushConstantRange           m_pushConstants;
+
     Flags<VkDescriptorType>         m_descriptorTypes;
     
   };
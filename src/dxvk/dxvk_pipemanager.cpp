@@ -1,4 +1,5 @@
 #include "dxvk_device.h"
+#include "dxvk_pipe_predictor.h"
 #include "dxvk_pipemanager.h"
 #include "dxvk_state_cache.h"
 
@@ -42,17 +43,30 @@ namespace dxvk {
   DxvkPipelineManager::DxvkPipelineManager(
     const DxvkDevice*         device,
           DxvkRenderPassPool* passManager)
-  : m_device    (device),
-    m_cache     (new DxvkPipelineCache(device->vkd())) {
+  : m_device          (device),
+    m_cache           (new DxvkPipelineCache(device->vkd())),
+    m_shaderRegistry  (new DxvkShaderRegistry()) {
     std::string useStateCache = env::getEnvVar("DXVK_STATE_CACHE");
     
     if (useStateCache != "0" && device->config().enableStateCache)
       m_stateCache = new DxvkStateCache(device, this, passManager);
+    
+    if (device->config().enablePipelinePrediction)
+      m_predictor = new DxvkPipelinePredictor(this, passManager);
+    
+    if (device->config().slowCompileThreshold > 0)
+      m_slowCompileThreshold = uint64_t(device->config().slowCompileThreshold) * 1000;
   }
   
   
   DxvkPipelineManager::~DxvkPipelineManager() {
+    // Stop state cache and predictor workers
+    // so that the compile times are final
+    m_stateCache = nullptr;
+    m_predictor  = nullptr;
     
+    this->logCompileTimes();
+    this->logShaderDedup();
   }
   
   
@@ -108,10 +122,40 @@ namespace dxvk {
   }
 
   
-  void DxvkPipelineManager::registerShader(
+  Rc<DxvkShader> DxvkPipelineManager::registerShader(
     const Rc<DxvkShader>&         shader) {
+    // Applications often create shaders which only differ in
+    // debug or reflection data, and translate to the same code
+    Rc<DxvkShader> existing = m_shaderRegistry->lookupOrAdd(shader);
+    
+    if (existing != nullptr) {
+      m_numDuplicateShaders += 1;
+      
+      // Pipelines will be recorded with the key of the existing
+      // shader, but state cache entries and statistics may refer
+      // to the key of the new one, so register it as an alias.
+      DxvkShaderKey key = shader->getShaderKey();
+      
+      if (m_stateCache != nullptr)
+        m_stateCache->registerShader(existing, key);
+      
+      Rc<DxvkShaderStats> shaderStats = m_device->shaderStats();
+      
+      if (shaderStats != nullptr)
+        shaderStats->addAlias(existing->getShaderKey(), key);
+      
+      return existing;
+    }
+    
+    m_numUniqueShaders += 1;
+    
     if (m_stateCache != nullptr)
-      m_stateCache->registerShader(shader);
+      m_stateCache->registerShader(shader, shader->getShaderKey());
+    
+    if (m_predictor != nullptr)
+      m_predictor->registerShader(shader);
+    
+    return shader;
   }
 
 
@@ -121,5 +165,70 @@ namespace dxvk {
     result.numGraphicsPipelines = m_numGraphicsPipelines.load();
     return result;
   }
+
+
+  DxvkPipelineCompileStats DxvkPipelineManager::getCompileStats() const {
+    DxvkPipelineCompileStats result;
+    result.numFullPipelines     = m_numFullPipelines.load();
+    result.numDerivedPipelines  = m_numDerivedPipelines.load();
+    result.fullCompileTime      = m_fullCompileTime.load();
+    result.derivedCompileTime   = m_derivedCompileTime.load();
+    return result;
+  }
+  
+  
+  DxvkPipelineCompileTimes DxvkPipelineManager::getCompileTimes(
+          DxvkPipelineCompileType type) const {
+    std::lock_guard<sync::Spinlock> lock(m_compileTimeLock);
+    return m_compileTimes.at(uint32_t(type));
+  }
+  
+  
+  bool DxvkPipelineManager::recordCompileTime(
+          DxvkPipelineCompileType type,
+          uint64_t                time) {
+    { std::lock_guard<sync::Spinlock> lock(m_compileTimeLock);
+      
+      auto& entry = m_compileTimes.at(uint32_t(type));
+      entry.numPipelines += 1;
+      entry.compileTime  += time;
+      entry.histogram.addTime(time);
+    }
+    
+    return m_slowCompileThreshold != 0
+        && m_slowCompileThreshold <= time;
+  }
+  
+  
+  void DxvkPipelineManager::logCompileTimes() const {
+    DxvkPipelineCompileTimes sync  = getCompileTimes(DxvkPipelineCompileType::Sync);
+    DxvkPipelineCompileTimes async = getCompileTimes(DxvkPipelineCompileType::Async);
+    
+    if (!sync.numPipelines && !async.numPipelines)
+      return;
+    
+    Logger::info("DXVK: Pipeline compile times:");
+    Logger::info(str::format("  On demand:  ", sync .numPipelines, " pipelines, ", sync .compileTime / 1000, " ms"));
+    Logger::info(str::format("  Background: ", async.numPipelines, " pipelines, ", async.compileTime / 1000, " ms"));
+    
+    for (uint32_t i = 0; i < DxvkTimeHistogram::BucketCount; i++) {
+      Logger::info(str::format("  ", DxvkTimeHistogram::getBucketName(i), ": ",
+        sync.histogram.getCount(i), " on demand, ",
+        async.histogram.getCount(i), " background"));
+    }
+  }
+  
+  
+  void DxvkPipelineManager::logShaderDedup() const {
+    uint32_t numDuplicates = m_numDuplicateShaders.load();
+    uint32_t numShaders    = m_numUniqueShaders.load() + numDuplicates;
+    
+    if (!numShaders)
+      return;
+    
+    Logger::info(str::format("DXVK: Shader deduplication: ",
+      numDuplicates, " of ", numShaders, " shaders (",
+      numDuplicates * 100 / numShaders, "%) shared with identical shaders"));
+  }
   
 }
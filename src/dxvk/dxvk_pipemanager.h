@@ -8,6 +8,7 @@
 
 namespace dxvk {
 
+  class DxvkPipelinePredictor;
   class DxvkStateCache;
 
   /**
@@ -21,6 +22,33 @@ namespace dxvk {
     uint32_t numComputePipelines;
   };
   
+  /**
+   * \brief Pipeline compile stats
+   * 
+   * Stores the number of graphics pipelines compiled
+   * with and without a base pipeline, as well as the
+   * total time spent compiling them, in microseconds.
+   */
+  struct DxvkPipelineCompileStats {
+    uint64_t numFullPipelines;
+    uint64_t numDerivedPipelines;
+    uint64_t fullCompileTime;
+    uint64_t derivedCompileTime;
+  };
+  
+  /**
+   * \brief Pipeline compile times
+   * 
+   * Stores the number of pipelines compiled in a given
+   * way, the total time spent compiling them, in
+   * microseconds, and a histogram of compile times.
+   */
+  struct DxvkPipelineCompileTimes {
+    uint64_t          numPipelines = 0;
+    uint64_t          compileTime  = 0;
+    DxvkTimeHistogram histogram;
+  };
+  
   /**
    * \brief Compute pipeline key
    * 
@@ -114,12 +142,20 @@ namespace dxvk {
     /*
      * \brief Registers a shader
      * 
-     * Starts compiling pipelines asynchronously
+     * If a shader with the same content hash has
+     * already been registered, that shader will be
+     * returned instead, so that both share their
+     * shader modules and pipelines, and the key of
+     * the new shader is registered as an alias for
+     * the existing one. Otherwise,
+     * starts compiling pipelines asynchronously
      * in case the state cache contains state
-     * vectors for this shader.
+     * vectors for this shader, or if pipelines
+     * using this shader can be predicted.
      * \param [in] shader Newly compiled shader
+     * \returns The shader that should be used
      */
-    void registerShader(
+    Rc<DxvkShader> registerShader(
       const Rc<DxvkShader>&         shader);
     
     /**
@@ -127,17 +163,51 @@ namespace dxvk {
      * \returns Number of compute/graphics pipelines
      */
     DxvkPipelineCount getPipelineCount() const;
+    
+    /**
+     * \brief Retrieves pipeline compile stats
+     * \returns Pipeline compile counts and times
+     */
+    DxvkPipelineCompileStats getCompileStats() const;
+    
+    /**
+     * \brief Retrieves pipeline compile times
+     * 
+     * \param [in] type Compile type
+     * \returns Compile times for the given type
+     */
+    DxvkPipelineCompileTimes getCompileTimes(
+            DxvkPipelineCompileType type) const;
+    
   private:
     
     const DxvkDevice*         m_device;
     Rc<DxvkPipelineCache>     m_cache;
     Rc<DxvkStateCache>        m_stateCache;
+    Rc<DxvkPipelinePredictor> m_predictor;
 
     std::atomic<uint32_t>     m_numComputePipelines  = { 0 };
     std::atomic<uint32_t>     m_numGraphicsPipelines = { 0 };
+
+    std::atomic<uint64_t>     m_numFullPipelines     = { 0 };
+    std::atomic<uint64_t>     m_numDerivedPipelines  = { 0 };
+    std::atomic<uint64_t>     m_fullCompileTime      = { 0 };
+    std::atomic<uint64_t>     m_derivedCompileTime   = { 0 };
+    
+    mutable sync::Spinlock    m_compileTimeLock;
+    
+    std::array<DxvkPipelineCompileTimes, 2> m_compileTimes;
+    
+    // Compiles that take longer than this, in
+    // microseconds, are logged with their shaders
+    uint64_t                  m_slowCompileThreshold = 0;
     
     std::mutex m_mutex;
     
+    Rc<DxvkShaderRegistry>    m_shaderRegistry;
+    std::atomic<uint32_t>     m_numUniqueShaders     = { 0 };
+    std::atomic<uint32_t>     m_numDuplicateShaders  = { 0 };
+    
     std::unordered_map<
       DxvkComputePipelineKey,
       Rc<DxvkComputePipeline>,
@@ -150,6 +220,14 @@ namespace dxvk {
       DxvkPipelineKeyHash,
       DxvkPipelineKeyEq> m_graphicsPipelines;
     
+    bool recordCompileTime(
+            DxvkPipelineCompileType type,
+            uint64_t                time);
+    
+    void logCompileTimes() const;
+    
+    void logShaderDedup() const;
+    
   };
   
 }
\ No newline at end of file
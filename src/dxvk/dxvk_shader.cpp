@@ -1,7 +1,82 @@
+#include <array>
+#include <atomic>
+#include <list>
+
 #include "dxvk_shader.h"
 
+#include "../spirv/spirv_optimizer.h"
+#include "../spirv/spirv_output_pruner.h"
+
 namespace dxvk {
   
+  /**
+   * \brief Uncompressed shader code cache
+   * 
+   * Keeps the uncompressed code of the most recently
+   * used shaders, so that creating several modules
+   * for the same shader in a row only decompresses
+   * the code once. Entries are identified by a serial
+   * number rather than the shader object, so that
+   * entries of destroyed shaders simply age out.
+   */
+  class DxvkShaderCodeLru {
+    constexpr static size_t MaxEntries = 16;
+  public:
+    
+    SpirvCodeBuffer getCode(
+            uint64_t                serial,
+      const SpirvCompressedBuffer&  code) {
+      { std::lock_guard<std::mutex> lock(m_mutex);
+        
+        for (auto e = m_entries.begin(); e != m_entries.end(); e++) {
+          if (e->serial == serial) {
+            m_entries.splice(m_entries.begin(), m_entries, e);
+            return e->code;
+          }
+        }
+      }
+      
+      // Decompress without holding the lock. If another
+      // thread does the same, we may end up with a
+      // duplicate entry, which is harmless.
+      SpirvCodeBuffer result = code.decompress();
+      
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_entries.push_front({ serial, result });
+      m_size += result.size();
+      
+      while (m_entries.size() > MaxEntries) {
+        m_size -= m_entries.back().code.size();
+        m_entries.pop_back();
+      }
+      
+      return result;
+    }
+    
+    uint64_t size() const {
+      return m_size.load();
+    }
+    
+  private:
+    
+    struct Entry {
+      uint64_t        serial;
+      SpirvCodeBuffer code;
+    };
+    
+    std::mutex            m_mutex;
+    std::list<Entry>      m_entries;
+    std::atomic<uint64_t> m_size = { 0ull };
+    
+  };
+  
+  static DxvkShaderCodeLru      g_shaderCodeLru;
+  
+  static std::atomic<uint64_t>  g_shaderSerial           = { 0ull };
+  static std::atomic<uint64_t>  g_shaderCompressedSize   = { 0ull };
+  static std::atomic<uint64_t>  g_shaderUncompressedSize = { 0ull };
+  
+  
   DxvkShaderConstData::DxvkShaderConstData() {
 
   }
@@ -38,11 +113,32 @@ namespace dxvk {
   }
 
 
+  bool DxvkShaderModuleKey::eq(const DxvkShaderModuleKey& other) const {
+    return this->bindingIds     == other.bindingIds
+        && this->fsDualSrcBlend == other.fsDualSrcBlend
+        && this->outputMask     == other.outputMask;
+  }
+  
+  
+  size_t DxvkShaderModuleKey::hash() const {
+    std::hash<uint32_t> uhash;
+    
+    DxvkHashState result;
+    result.add(uint32_t(fsDualSrcBlend));
+    result.add(outputMask);
+    
+    for (uint32_t id : bindingIds)
+      result.add(uhash(id));
+    
+    return result;
+  }
+  
+  
   DxvkShaderModule::DxvkShaderModule(
     const Rc<vk::DeviceFn>&     vkd,
-    const Rc<DxvkShader>&       shader,
+          VkShaderStageFlagBits stage,
     const SpirvCodeBuffer&      code)
-  : m_vkd(vkd), m_shader(shader) {
+  : m_vkd(vkd), m_stage(stage) {
     VkShaderModuleCreateInfo info;
     info.sType    = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
     info.pNext    = nullptr;
@@ -67,7 +163,7 @@ namespace dxvk {
     info.sType                = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     info.pNext                = nullptr;
     info.flags                = 0;
-    info.stage                = m_shader->stage();
+    info.stage                = m_stage;
     info.module               = m_module;
     info.pName                = "main";
     info.pSpecializationInfo  = specInfo;
@@ -80,11 +176,12 @@ namespace dxvk {
           uint32_t                slotCount,
     const DxvkResourceSlot*       slotInfos,
     const DxvkInterfaceSlots&     iface,
-    const SpirvCodeBuffer&        code,
+          SpirvCodeBuffer         code,
     const DxvkShaderOptions&      options,
           DxvkShaderConstData&&   constData)
   : m_stage(stage), m_code(code), m_interface(iface),
-    m_options(options), m_constData(std::move(constData)) {
+    m_options(options), m_constData(std::move(constData)),
+    m_serial(++g_shaderSerial) {
     // Write back resource slot infos
     for (uint32_t i = 0; i < slotCount; i++)
       m_slots.push_back(slotInfos[i]);
@@ -93,11 +190,16 @@ namespace dxvk {
     // are stored so we can quickly remap them.
     uint32_t o1VarId = 0;
     
-    for (auto ins : m_code) {
+    for (auto ins : code) {
+      if (ins.opCode() == spv::OpCapability)
+        m_capabilities.push_back(spv::Capability(ins.arg(1)));
+      
       if (ins.opCode() == spv::OpDecorate) {
         if (ins.arg(2) == spv::DecorationBinding
-         || ins.arg(2) == spv::DecorationSpecId)
+         || ins.arg(2) == spv::DecorationSpecId) {
           m_idOffsets.push_back(ins.offset() + 3);
+          m_idValues.push_back(ins.arg(3));
+        }
         
         if (ins.arg(2) == spv::DecorationLocation && ins.arg(3) == 1) {
           m_o1LocOffset = ins.offset() + 3;
@@ -108,21 +210,37 @@ namespace dxvk {
           m_o1IdxOffset = ins.offset() + 3;
       }
     }
+    
+    // Hash everything that write() stores, so that
+    // equal hashes imply interchangeable shaders
+    const std::array<Sha1Data, 6> hashData = {{
+      { &m_stage,             sizeof(m_stage) },
+      { m_slots.data(),       sizeof(DxvkResourceSlot) * m_slots.size() },
+      { &m_interface,         sizeof(m_interface) },
+      { &m_options,           sizeof(m_options) },
+      { code.data(),          code.size() },
+      { m_constData.data(),   m_constData.sizeInBytes() },
+    }};
+    
+    m_contentHash = Sha1Hash::compute(hashData.size(), hashData.data());
+    
+    g_shaderCompressedSize   += m_code.size();
+    g_shaderUncompressedSize += m_code.uncompressedSize();
   }
   
   
   DxvkShader::~DxvkShader() {
+    if (m_registry != nullptr)
+      m_registry->remove(this);
     
+    g_shaderCompressedSize   -= m_code.size();
+    g_shaderUncompressedSize -= m_code.uncompressedSize();
   }
   
   
-  bool DxvkShader::hasCapability(spv::Capability cap) {
-    for (auto ins : m_code) {
-      // OpCapability instructions come first
-      if (ins.opCode() != spv::OpCapability)
-        return false;
-      
-      if (ins.arg(1) == cap)
+  bool DxvkShader::hasCapability(spv::Capability cap) const {
+    for (spv::Capability c : m_capabilities) {
+      if (c == cap)
         return true;
     }
     
@@ -130,6 +248,11 @@ namespace dxvk {
   }
   
   
+  SpirvCodeBuffer DxvkShader::getCode() const {
+    return g_shaderCodeLru.getCode(m_serial, m_code);
+  }
+  
+  
   void DxvkShader::defineResourceSlots(
           DxvkDescriptorSlotMapping& mapping) const {
     for (const auto& slot : m_slots)
@@ -141,26 +264,165 @@ namespace dxvk {
     const Rc<vk::DeviceFn>&          vkd,
     const DxvkDescriptorSlotMapping& mapping,
     const DxvkShaderModuleCreateInfo& info) {
-    SpirvCodeBuffer spirvCode = m_code;
+    // Compute the remapped binding IDs first, so that
+    // we only copy the code if we need a new module
+    DxvkShaderModuleKey key;
+    key.bindingIds.reserve(m_idOffsets.size());
+    key.fsDualSrcBlend = info.fsDualSrcBlend
+      && m_o1IdxOffset && m_o1LocOffset;
+    key.outputMask = m_interface.outputSlots;
+    
+    if (m_options.pruneOutputs
+     && (m_stage == VK_SHADER_STAGE_VERTEX_BIT
+      || m_stage == VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT
+      || m_stage == VK_SHADER_STAGE_GEOMETRY_BIT))
+      key.outputMask &= info.outputMask;
+    
+    for (uint32_t id : m_idValues) {
+      key.bindingIds.push_back(id < MaxNumResourceSlots
+        ? mapping.getBindingId(id)
+        : id);
+    }
+    
+    std::lock_guard<std::mutex> lock(m_moduleMutex);
+    
+    auto entry = m_modules.find(key);
+    
+    if (entry != m_modules.end())
+      return entry->second;
+    
+    SpirvCodeBuffer spirvCode = this->getCode();
     uint32_t* code = spirvCode.data();
     
     // Remap resource binding IDs
-    for (uint32_t ofs : m_idOffsets) {
-      if (code[ofs] < MaxNumResourceSlots)
-        code[ofs] = mapping.getBindingId(code[ofs]);
-    }
+    for (size_t i = 0; i < m_idOffsets.size(); i++)
+      code[m_idOffsets[i]] = key.bindingIds[i];
 
     // For dual-source blending we need to re-map
     // location 1, index 0 to location 0, index 1
-    if (info.fsDualSrcBlend && m_o1IdxOffset && m_o1LocOffset)
+    if (key.fsDualSrcBlend)
       std::swap(code[m_o1IdxOffset], code[m_o1LocOffset]);
     
-    return new DxvkShaderModule(vkd, this, spirvCode);
+    // Demote unused outputs to private variables and let
+    // the optimizer remove the code that computes them
+    if (key.outputMask != m_interface.outputSlots) {
+      if (SpirvOutputPruner().prune(spirvCode, key.outputMask))
+        SpirvOptimizer().optimize(spirvCode);
+    }
+    
+    Rc<DxvkShaderModule> module = new DxvkShaderModule(vkd, m_stage, spirvCode);
+    m_modules.insert({ std::move(key), module });
+    return module;
   }
   
   
   void DxvkShader::dump(std::ostream& outputStream) const {
-    m_code.store(outputStream);
+    this->getCode().store(outputStream);
+  }
+  
+  
+  void DxvkShader::write(std::ostream& stream) const {
+    SpirvCodeBuffer code = this->getCode();
+    
+    uint32_t slotCount  = m_slots.size();
+    uint32_t codeSize   = code.size() / sizeof(uint32_t);
+    uint32_t constSize  = m_constData.sizeInBytes() / sizeof(uint32_t);
+    
+    stream.write(reinterpret_cast<const char*>(&m_stage),     sizeof(m_stage));
+    stream.write(reinterpret_cast<const char*>(&slotCount),   sizeof(slotCount));
+    stream.write(reinterpret_cast<const char*>(m_slots.data()), sizeof(DxvkResourceSlot) * slotCount);
+    stream.write(reinterpret_cast<const char*>(&m_interface), sizeof(m_interface));
+    stream.write(reinterpret_cast<const char*>(&m_options),   sizeof(m_options));
+    stream.write(reinterpret_cast<const char*>(&codeSize),    sizeof(codeSize));
+    stream.write(reinterpret_cast<const char*>(code.data()), sizeof(uint32_t) * codeSize);
+    stream.write(reinterpret_cast<const char*>(&constSize),   sizeof(constSize));
+    stream.write(reinterpret_cast<const char*>(m_constData.data()), sizeof(uint32_t) * constSize);
+  }
+  
+  
+  Rc<DxvkShader> DxvkShader::read(std::istream& stream) {
+    VkShaderStageFlagBits stage;
+    DxvkInterfaceSlots    iface;
+    DxvkShaderOptions     options;
+    
+    uint32_t slotCount = 0;
+    uint32_t codeSize  = 0;
+    uint32_t constSize = 0;
+    
+    if (!stream.read(reinterpret_cast<char*>(&stage),     sizeof(stage))
+     || !stream.read(reinterpret_cast<char*>(&slotCount), sizeof(slotCount))
+     || slotCount > MaxNumResourceSlots)
+      return nullptr;
+    
+    std::vector<DxvkResourceSlot> slots(slotCount);
+    
+    if (!stream.read(reinterpret_cast<char*>(slots.data()), sizeof(DxvkResourceSlot) * slotCount)
+     || !stream.read(reinterpret_cast<char*>(&iface),    sizeof(iface))
+     || !stream.read(reinterpret_cast<char*>(&options),  sizeof(options))
+     || !stream.read(reinterpret_cast<char*>(&codeSize), sizeof(codeSize)))
+      return nullptr;
+    
+    std::vector<uint32_t> code(codeSize);
+    
+    if (!stream.read(reinterpret_cast<char*>(code.data()), sizeof(uint32_t) * codeSize)
+     || !stream.read(reinterpret_cast<char*>(&constSize),  sizeof(constSize)))
+      return nullptr;
+    
+    std::vector<uint32_t> constData(constSize);
+    
+    if (!stream.read(reinterpret_cast<char*>(constData.data()), sizeof(uint32_t) * constSize))
+      return nullptr;
+    
+    return new DxvkShader(stage,
+      slots.size(), slots.data(), iface,
+      SpirvCodeBuffer(code.size(), code.data()), options,
+      constSize ? DxvkShaderConstData(constData.size(), constData.data())
+                : DxvkShaderConstData());
+  }
+  
+  
+  DxvkShaderCodeStats DxvkShader::getCodeStats() {
+    DxvkShaderCodeStats result;
+    result.compressedSize   = g_shaderCompressedSize.load();
+    result.uncompressedSize = g_shaderUncompressedSize.load();
+    result.cachedSize       = g_shaderCodeLru.size();
+    return result;
+  }
+  
+  
+  Rc<DxvkShader> DxvkShaderRegistry::lookupOrAdd(
+    const Rc<DxvkShader>&         shader) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto entry = m_shaders.insert({ shader->contentHash(), shader.ptr() });
+    
+    // The existing shader may already be in the process of
+    // being destroyed, in which case we replace the entry.
+    if (!entry.second) {
+      DxvkShader* existing = entry.first->second;
+      
+      if (existing->tryIncRef()) {
+        Rc<DxvkShader> result = existing;
+        existing->decRef();
+        return result;
+      }
+      
+      entry.first->second = shader.ptr();
+    }
+    
+    shader->m_registry = this;
+    return nullptr;
+  }
+  
+  
+  void DxvkShaderRegistry::remove(
+    const DxvkShader*             shader) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto entry = m_shaders.find(shader->contentHash());
+    
+    if (entry != m_shaders.end() && entry->second == shader)
+      m_shaders.erase(entry);
   }
   
-}
\ No newline at end of file
+}
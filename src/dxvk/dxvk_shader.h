@@ -1,18 +1,23 @@
 #pragma once
 
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
+#include "dxvk_hash.h"
 #include "dxvk_include.h"
 #include "dxvk_limits.h"
 #include "dxvk_pipelayout.h"
 #include "dxvk_shader_key.h"
 
 #include "../spirv/spirv_code_buffer.h"
+#include "../spirv/spirv_compression.h"
 
 namespace dxvk {
   
   class DxvkShader;
   class DxvkShaderModule;
+  class DxvkShaderRegistry;
   
   /**
    * \brief Built-in specialization constants
@@ -30,10 +35,11 @@ namespace dxvk {
     // Specialization constants for pipeline state
     SpecConstantRangeStart      = ColorComponentMappings + MaxNumRenderTargets * 4,
     RasterizerSampleCount       = SpecConstantRangeStart + 0,
+    PushConstantStage           = SpecConstantRangeStart + 1,
 
     /// Lowest and highest known spec constant IDs
     SpecConstantIdMin           = RasterizerSampleCount,
-    SpecConstantIdMax           = RasterizerSampleCount,
+    SpecConstantIdMax           = PushConstantStage,
   };
   
   
@@ -61,6 +67,15 @@ namespace dxvk {
     int32_t rasterizedStream;
     /// Xfb vertex strides
     uint32_t xfbStrides[MaxNumXfbBuffers];
+    /// Resource slot of the constant buffer
+    /// that can be read from push constants
+    uint32_t pushConstSlot;
+    /// Size of that constant buffer, in bytes,
+    /// or zero if push constants are not used
+    uint32_t pushConstSize;
+    /// Remove outputs that the next stage does
+    /// not consume when creating shader modules
+    VkBool32 pruneOutputs;
   };
 
 
@@ -107,7 +122,46 @@ namespace dxvk {
    * \brief Shader module create info
    */
   struct DxvkShaderModuleCreateInfo {
+    /// Remap fragment shader output 1
+    /// for dual-source blending
     bool fsDualSrcBlend;
+    /// Output locations consumed by the next
+    /// stage. Only used for the last stage
+    /// before rasterization.
+    uint32_t outputMask;
+  };
+  
+  
+  /**
+   * \brief Shader module key
+   * 
+   * Identifies a shader module created from a given
+   * shader. Stores the binding IDs that resource slots
+   * have been remapped to, in the order in which they
+   * occur in the shader code, so that pipelines with
+   * compatible slot mappings can share modules.
+   */
+  struct DxvkShaderModuleKey {
+    std::vector<uint32_t> bindingIds;
+    bool                  fsDualSrcBlend;
+    uint32_t              outputMask;
+    
+    bool eq(const DxvkShaderModuleKey& other) const;
+    
+    size_t hash() const;
+  };
+  
+  
+  /**
+   * \brief Shader code memory statistics
+   * 
+   * Memory used to store the SPIR-V code of
+   * all live shader objects, in bytes.
+   */
+  struct DxvkShaderCodeStats {
+    uint64_t compressedSize;
+    uint64_t uncompressedSize;
+    uint64_t cachedSize;
   };
   
   
@@ -118,9 +172,13 @@ namespace dxvk {
    * bindings that the shader uses. In order to use
    * the shader with a pipeline, a shader module
    * needs to be created from he shader object.
+   * 
+   * The SPIR-V code is kept in compressed form, and
+   * the code of recently used shaders is cached in
+   * a small, process-wide LRU list.
    */
   class DxvkShader : public RcObject {
-    
+    friend class DxvkShaderRegistry;
   public:
     
     DxvkShader(
@@ -128,7 +186,7 @@ namespace dxvk {
             uint32_t                slotCount,
       const DxvkResourceSlot*       slotInfos,
       const DxvkInterfaceSlots&     iface,
-      const SpirvCodeBuffer&        code,
+            SpirvCodeBuffer         code,
       const DxvkShaderOptions&      options,
             DxvkShaderConstData&&   constData);
     
@@ -152,7 +210,26 @@ namespace dxvk {
      * \param [in] cap The capability to check
      * \returns \c true if \c cap is enabled
      */
-    bool hasCapability(spv::Capability cap);
+    bool hasCapability(spv::Capability cap) const;
+    
+    /**
+     * \brief Retrieves the shader code
+     * 
+     * Decompresses the code, or returns a copy of
+     * the cached code if it was recently used.
+     * \returns Uncompressed SPIR-V code
+     */
+    SpirvCodeBuffer getCode() const;
+    
+    /**
+     * \brief Uncompressed shader code size
+     * 
+     * Does not require the code to be decompressed.
+     * \returns Size of the SPIR-V code, in bytes
+     */
+    size_t getCodeSize() const {
+      return m_code.uncompressedSize();
+    }
     
     /**
      * \brief Adds resource slots definitions to a mapping
@@ -167,7 +244,17 @@ namespace dxvk {
     /**
      * \brief Creates a shader module
      * 
-     * Maps the binding slot numbers 
+     * Maps the binding slot numbers. Modules are cached
+     * per slot mapping and dual-source blending state,
+     * so that pipelines using the same shader with a
+     * compatible layout do not need to patch the code
+     * and create a new Vulkan shader module each time.
+     * 
+     * If enabled in the shader options, outputs of vertex,
+     * tessellation evaluation and geometry shaders that
+     * the next stage does not consume are removed along
+     * with the code that computes them, which results in
+     * one module variant per set of consumed outputs.
      * \param [in] vkd Vulkan device functions
      * \param [in] mapping Resource slot mapping
      * \param [in] info Module create info
@@ -209,6 +296,20 @@ namespace dxvk {
       return m_constData;
     }
     
+    /**
+     * \brief Content hash
+     * 
+     * Hash over the SPIR-V code, the resource and
+     * interface slots, the shader options and the
+     * constant data. Shaders with the same content
+     * hash behave identically in any pipeline, even
+     * if they were created from different code.
+     * \returns Content hash
+     */
+    Sha1Hash contentHash() const {
+      return m_contentHash;
+    }
+    
     /**
      * \brief Dumps SPIR-V shader
      * 
@@ -217,6 +318,36 @@ namespace dxvk {
      */
     void dump(std::ostream& outputStream) const;
     
+    /**
+     * \brief Writes shader to a stream
+     * 
+     * Stores everything needed to recreate the
+     * shader object, except for the shader key.
+     * \param [in] stream Stream to write to
+     */
+    void write(std::ostream& stream) const;
+    
+    /**
+     * \brief Reads shader from a stream
+     * 
+     * Recreates a shader previously written
+     * with \ref write. The shader key must be
+     * set separately.
+     * \param [in] stream Stream to read from
+     * \returns The shader, or \c nullptr if the
+     *    stream does not contain a valid shader
+     */
+    static Rc<DxvkShader> read(std::istream& stream);
+    
+    /**
+     * \brief Queries shader code memory usage
+     * 
+     * Includes all shader objects that are
+     * currently alive in the process.
+     * \returns Shader code memory statistics
+     */
+    static DxvkShaderCodeStats getCodeStats();
+    
     /**
      * \brief Sets the shader key
      * \param [in] key Unique key
@@ -244,21 +375,83 @@ namespace dxvk {
   private:
     
     VkShaderStageFlagBits m_stage;
-    SpirvCodeBuffer       m_code;
+    SpirvCompressedBuffer m_code;
     
     std::vector<DxvkResourceSlot> m_slots;
     std::vector<size_t>           m_idOffsets;
+    std::vector<uint32_t>         m_idValues;
+    std::vector<spv::Capability>  m_capabilities;
     DxvkInterfaceSlots            m_interface;
     DxvkShaderOptions             m_options;
     DxvkShaderConstData           m_constData;
     DxvkShaderKey                 m_key;
+    Sha1Hash                      m_contentHash;
+    uint64_t                      m_serial;
+    
+    Rc<DxvkShaderRegistry>        m_registry;
 
     size_t m_o1IdxOffset = 0;
     size_t m_o1LocOffset = 0;
     
+    std::mutex                    m_moduleMutex;
+    
+    std::unordered_map<
+      DxvkShaderModuleKey,
+      Rc<DxvkShaderModule>,
+      DxvkHash, DxvkEq>           m_modules;
+    
   };
   
 
+  /**
+   * \brief Shader registry
+   * 
+   * Maps content hashes to shaders so that identical
+   * shaders can be shared. Does not keep shaders alive,
+   * instead, shaders remove themselves when destroyed.
+   * This class is thread-safe.
+   */
+  class DxvkShaderRegistry : public RcObject {
+    
+  public:
+    
+    /**
+     * \brief Looks up or adds a shader
+     * 
+     * \param [in] shader Newly compiled shader
+     * \returns An existing shader with the same content
+     *    hash, or \c nullptr if the shader was added
+     */
+    Rc<DxvkShader> lookupOrAdd(
+      const Rc<DxvkShader>&         shader);
+    
+    /**
+     * \brief Removes a shader
+     * 
+     * Called when a registered shader is destroyed.
+     * \param [in] shader The shader to remove
+     */
+    void remove(
+      const DxvkShader*             shader);
+    
+  private:
+    
+    struct ShaderHash {
+      size_t operator () (const Sha1Hash& key) const {
+        return key.dword(0);
+      }
+    };
+    
+    std::mutex m_mutex;
+    
+    std::unordered_map<
+      Sha1Hash,
+      DxvkShader*,
+      ShaderHash> m_shaders;
+    
+  };
+  
+  
   /**
    * \brief Shader module object
    * 
@@ -266,6 +459,9 @@ namespace dxvk {
    * perform any shader compilation. Instead, the
    * context will create pipeline objects on the
    * fly when executing draw calls.
+   * 
+   * Modules are owned by the shader they were created
+   * from, so they must not reference the shader object.
    */
   class DxvkShaderModule : public RcObject {
     
@@ -273,7 +469,7 @@ namespace dxvk {
     
     DxvkShaderModule(
       const Rc<vk::DeviceFn>&     vkd,
-      const Rc<DxvkShader>&       shader,
+            VkShaderStageFlagBits stage,
       const SpirvCodeBuffer&      code);
     
     ~DxvkShaderModule();
@@ -295,26 +491,10 @@ namespace dxvk {
     VkPipelineShaderStageCreateInfo stageInfo(
       const VkSpecializationInfo* specInfo) const;
     
-    /**
-     * \brief Shader object
-     * \returns The shader
-     */
-    Rc<DxvkShader> shader() const {
-      return m_shader;
-    }
-
-    /**
-     * \brief Retrieves shader key
-     * \returns Unique shader key
-     */
-    DxvkShaderKey getShaderKey() const {
-      return m_shader->getShaderKey();
-    }
-    
   private:
     
     Rc<vk::DeviceFn>      m_vkd;
-    Rc<DxvkShader>        m_shader;
+    VkShaderStageFlagBits m_stage;
     VkShaderModule        m_module;
     
   };
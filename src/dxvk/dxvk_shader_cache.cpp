@@ -0,0 +1,224 @@
+#include <cstring>
+#include <sstream>
+
+#include <version.h>
+
+#include "dxvk_shader_cache.h"
+
+namespace dxvk {
+
+  DxvkShaderCache::DxvkShaderCache() {
+    std::string fileName = getCacheFileName();
+
+    // Start with an empty cache if the file does not exist
+    // or is invalid, since we cannot safely append to it
+    if (!readCacheFile(fileName)) {
+      m_entries.clear();
+
+      if (!createCacheFile(fileName))
+        return;
+    }
+
+    m_file.open(fileName,
+      std::ios_base::binary |
+      std::ios_base::in     |
+      std::ios_base::out);
+
+    if (!m_file) {
+      Logger::warn("DXVK: Failed to open shader cache file");
+      m_entries.clear();
+    }
+  }
+
+
+  DxvkShaderCache::~DxvkShaderCache() {
+    uint32_t numHits   = m_numHits.load();
+    uint32_t numMisses = m_numMisses.load();
+
+    if (numHits || numMisses) {
+      Logger::info(str::format("DXVK: Shader cache: ",
+        numHits, " hits, ", numMisses, " misses"));
+    }
+  }
+
+
+  Rc<DxvkShader> DxvkShaderCache::lookupShader(
+    const Sha1Hash&             key) {
+    std::vector<char> data;
+
+    { std::lock_guard<std::mutex> lock(m_mutex);
+
+      auto entry = m_entries.find(key);
+
+      if (entry == m_entries.end() || !m_file.is_open()) {
+        m_numMisses += 1;
+        return nullptr;
+      }
+
+      data.resize(entry->second.size);
+
+      m_file.seekg(entry->second.offset);
+      m_file.read(data.data(), data.size());
+
+      if (!m_file || !(Sha1Hash::compute(data.data(), data.size()) == entry->second.hash)) {
+        Logger::warn(str::format("DXVK: Corrupted shader cache entry: ", key.toString()));
+        m_file.clear();
+        m_entries.erase(entry);
+        m_numMisses += 1;
+        return nullptr;
+      }
+    }
+
+    // Deserialize the shader without holding the lock
+    std::istringstream stream(std::string(data.data(), data.size()));
+    Rc<DxvkShader> shader = DxvkShader::read(stream);
+
+    if (shader == nullptr) {
+      Logger::warn(str::format("DXVK: Invalid shader cache entry: ", key.toString()));
+      m_numMisses += 1;
+      return nullptr;
+    }
+
+    m_numHits += 1;
+    return shader;
+  }
+
+
+  void DxvkShaderCache::addShader(
+    const Sha1Hash&             key,
+    const Rc<DxvkShader>&       shader) {
+    std::ostringstream stream;
+    shader->write(stream);
+
+    std::string data = stream.str();
+
+    DxvkShaderCacheEntryHeader header;
+    header.key  = key;
+    header.hash = Sha1Hash::compute(data.data(), data.size());
+    header.size = data.size();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_file.is_open() || m_entries.find(key) != m_entries.end())
+      return;
+
+    m_file.seekp(m_fileSize);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(data.data(), data.size());
+    m_file.flush();
+
+    if (!m_file) {
+      Logger::warn("DXVK: Failed to write shader cache entry");
+      m_file.close();
+      return;
+    }
+
+    Entry entry;
+    entry.offset = m_fileSize + sizeof(header);
+    entry.size   = header.size;
+    entry.hash   = header.hash;
+
+    m_entries.insert({ key, entry });
+    m_fileSize = entry.offset + entry.size;
+  }
+
+
+  bool DxvkShaderCache::readCacheFile(
+    const std::string&          fileName) {
+    std::ifstream file(fileName, std::ios_base::binary);
+
+    if (!file) {
+      Logger::warn("DXVK: No shader cache file found");
+      return false;
+    }
+
+    DxvkShaderCacheHeader newHeader;
+    DxvkShaderCacheHeader curHeader;
+    newHeader.buildId = getBuildId();
+
+    if (!file.read(reinterpret_cast<char*>(&curHeader), sizeof(curHeader))) {
+      Logger::warn("DXVK: Failed to read shader cache header");
+      return false;
+    }
+
+    if (std::memcmp(curHeader.magic, newHeader.magic, sizeof(newHeader.magic))
+     || curHeader.version != newHeader.version
+     || !(curHeader.buildId == newHeader.buildId)) {
+      Logger::warn("DXVK: Shader cache out of date");
+      return false;
+    }
+
+    file.seekg(0, std::ios_base::end);
+    uint64_t fileSize = file.tellg();
+    uint64_t offset   = sizeof(curHeader);
+
+    // Only read the entry headers here, the shader
+    // data itself is read when a shader is needed
+    while (offset < fileSize) {
+      DxvkShaderCacheEntryHeader header;
+      file.seekg(offset);
+
+      if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+       || offset + sizeof(header) + header.size > fileSize) {
+        Logger::warn("DXVK: Failed to read shader cache entry");
+        return false;
+      }
+
+      Entry entry;
+      entry.offset = offset + sizeof(header);
+      entry.size   = header.size;
+      entry.hash   = header.hash;
+
+      m_entries.insert({ header.key, entry });
+      offset = entry.offset + entry.size;
+    }
+
+    m_fileSize = offset;
+
+    Logger::info(str::format("DXVK: Read ", m_entries.size(),
+      " shaders from shader cache"));
+    return true;
+  }
+
+
+  bool DxvkShaderCache::createCacheFile(
+    const std::string&          fileName) {
+    std::ofstream file(fileName,
+      std::ios_base::binary |
+      std::ios_base::trunc);
+
+    DxvkShaderCacheHeader header;
+    header.buildId = getBuildId();
+
+    if (!file.write(reinterpret_cast<const char*>(&header), sizeof(header))) {
+      Logger::warn("DXVK: Failed to create shader cache file");
+      return false;
+    }
+
+    m_fileSize = sizeof(header);
+    return true;
+  }
+
+
+  Sha1Hash DxvkShaderCache::getBuildId() {
+    return Sha1Hash::compute(DXVK_VERSION, std::strlen(DXVK_VERSION));
+  }
+
+
+  std::string DxvkShaderCache::getCacheFileName() {
+    std::string path = env::getEnvVar("DXVK_STATE_CACHE_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    std::string exeName = env::getExeName();
+    auto extp = exeName.find_last_of('.');
+
+    if (extp != std::string::npos && exeName.substr(extp + 1) == "exe")
+      exeName.erase(extp);
+
+    path += exeName + ".dxvk-shaders";
+    return path;
+  }
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <unordered_map>
+
+#include "dxvk_shader.h"
+
+#include "../util/sha1/sha1_util.h"
+
+namespace dxvk {
+
+  class DxvkDevice;
+
+  /**
+   * \brief Shader cache header
+   *
+   * Stores the cache version as well as a hash of
+   * the DXVK version string, since shaders compiled
+   * by a different build may not be compatible.
+   */
+  struct DxvkShaderCacheHeader {
+    char     magic[4]   = { 'D', 'X', 'V', 'K' };
+    uint32_t version    = 3;
+    Sha1Hash buildId;
+  };
+
+
+  /**
+   * \brief Shader cache entry header
+   *
+   * Precedes the serialized shader data. The
+   * data hash is used to detect corruption.
+   */
+  struct DxvkShaderCacheEntryHeader {
+    Sha1Hash key;
+    Sha1Hash hash;
+    uint32_t size;
+  };
+
+
+  /**
+   * \brief Shader cache
+   *
+   * Stores translated shaders on disk so that the client
+   * API does not need to translate them again on future
+   * runs of an application. Shaders are looked up by a
+   * key that must be computed by the client API from the
+   * original shader code and all options that affect the
+   * translated code. This class is thread-safe.
+   */
+  class DxvkShaderCache : public RcObject {
+
+  public:
+
+    DxvkShaderCache();
+
+    ~DxvkShaderCache();
+
+    /**
+     * \brief Looks up a shader
+     *
+     * \param [in] key Shader cache key
+     * \returns The shader, or \c nullptr if the
+     *    cache does not contain a valid shader
+     *    for the given key
+     */
+    Rc<DxvkShader> lookupShader(
+      const Sha1Hash&             key);
+
+    /**
+     * \brief Adds a shader to the cache
+     *
+     * Writes the shader to the cache file unless
+     * the cache already contains the given key.
+     * \param [in] key Shader cache key
+     * \param [in] shader The shader
+     */
+    void addShader(
+      const Sha1Hash&             key,
+      const Rc<DxvkShader>&       shader);
+
+  private:
+
+    struct Entry {
+      uint64_t offset;
+      uint32_t size;
+      Sha1Hash hash;
+    };
+
+    struct KeyHash {
+      size_t operator () (const Sha1Hash& key) const {
+        return key.dword(0);
+      }
+    };
+
+    std::mutex      m_mutex;
+    std::fstream    m_file;
+    uint64_t        m_fileSize = 0;
+
+    std::unordered_map<Sha1Hash, Entry, KeyHash> m_entries;
+
+    std::atomic<uint32_t> m_numHits   = { 0u };
+    std::atomic<uint32_t> m_numMisses = { 0u };
+
+    bool readCacheFile(
+      const std::string&          fileName);
+
+    bool createCacheFile(
+      const std::string&          fileName);
+
+    static Sha1Hash getBuildId();
+
+    static std::string getCacheFileName();
+
+  };
+
+}
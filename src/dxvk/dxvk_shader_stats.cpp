@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <fstream>
+
+#include "dxvk_shader_stats.h"
+
+namespace dxvk {
+
+  DxvkShaderStats::DxvkShaderStats(DxvkShaderStatsFormat format)
+  : m_format(format) {
+
+  }
+
+
+  DxvkShaderStats::~DxvkShaderStats() {
+    EntryList entries(m_entries.begin(), m_entries.end());
+
+    if (entries.empty())
+      return;
+
+    // Sort by total cost so that the shaders which
+    // are most expensive end up at the top
+    std::sort(entries.begin(), entries.end(),
+      [] (const auto& a, const auto& b) {
+        return a.second.translateTimeUs + a.second.pipelineTimeUs
+             > b.second.translateTimeUs + b.second.pipelineTimeUs;
+      });
+
+    std::string fileName = getReportFileName(m_format);
+
+    std::ofstream stream(fileName, std::ios_base::trunc);
+
+    if (m_format == DxvkShaderStatsFormat::Json)
+      writeJson(stream, entries);
+    else
+      writeCsv(stream, entries);
+
+    if (!stream) {
+      Logger::warn(str::format("DXVK: Failed to write shader stats to ", fileName));
+      return;
+    }
+
+    Logger::info(str::format("DXVK: Wrote stats for ",
+      entries.size(), " shaders to ", fileName));
+  }
+
+
+  void DxvkShaderStats::addShader(
+    const DxvkShaderKey&          key,
+    const DxvkShaderStatsEntry&   entry) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The same shader can be created more than once,
+    // in which case we keep the pipeline statistics
+    DxvkShaderStatsEntry& dst = m_entries[key];
+    dst.dxbcSize          = entry.dxbcSize;
+    dst.dxbcInstructions  = entry.dxbcInstructions;
+    dst.spirvWords        = entry.spirvWords;
+    dst.translateTimeUs  += entry.translateTimeUs;
+  }
+
+
+  void DxvkShaderStats::addPipeline(
+    const DxvkShaderKey&          key,
+          uint64_t                timeUs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    addPipelineToEntry(key, timeUs);
+
+    auto aliases = m_aliases.equal_range(key);
+
+    for (auto a = aliases.first; a != aliases.second; a++)
+      addPipelineToEntry(a->second, timeUs);
+  }
+
+
+  void DxvkShaderStats::addAlias(
+    const DxvkShaderKey&          key,
+    const DxvkShaderKey&          alias) {
+    if (alias.eq(key))
+      return;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // The same shader can be created more than once,
+    // so make sure we do not count pipelines twice
+    auto aliases = m_aliases.equal_range(key);
+
+    for (auto a = aliases.first; a != aliases.second; a++) {
+      if (a->second.eq(alias))
+        return;
+    }
+
+    m_aliases.insert({ key, alias });
+  }
+
+
+  void DxvkShaderStats::addPipelineToEntry(
+    const DxvkShaderKey&          key,
+          uint64_t                timeUs) {
+    auto entry = m_entries.find(key);
+
+    if (entry == m_entries.end())
+      return;
+
+    entry->second.pipelineCount  += 1;
+    entry->second.pipelineTimeUs += timeUs;
+  }
+
+
+  Rc<DxvkShaderStats> DxvkShaderStats::createFromEnv() {
+    std::string format = env::getEnvVar("DXVK_SHADER_STATS");
+
+    if (format == "csv")
+      return new DxvkShaderStats(DxvkShaderStatsFormat::Csv);
+
+    if (format == "json")
+      return new DxvkShaderStats(DxvkShaderStatsFormat::Json);
+
+    if (!format.empty())
+      Logger::warn(str::format("DXVK: Invalid shader stats format: ", format));
+
+    return nullptr;
+  }
+
+
+  std::string DxvkShaderStats::getReportFileName(
+          DxvkShaderStatsFormat   format) {
+    std::string path = env::getEnvVar("DXVK_LOG_PATH");
+
+    if (!path.empty() && *path.rbegin() != '/')
+      path += '/';
+
+    std::string exeName = env::getExeName();
+    auto extp = exeName.find_last_of('.');
+
+    if (extp != std::string::npos && exeName.substr(extp + 1) == "exe")
+      exeName.erase(extp);
+
+    path += exeName + (format == DxvkShaderStatsFormat::Json
+      ? "_shaders.json" : "_shaders.csv");
+    return path;
+  }
+
+
+  void DxvkShaderStats::writeCsv(
+          std::ostream&           stream,
+    const EntryList&              entries) {
+    stream << "shader,dxbc_size,dxbc_instructions,spirv_words,"
+              "translate_time_us,pipelines,pipeline_time_us" << std::endl;
+
+    for (const auto& e : entries) {
+      stream << e.first.toString()          << ","
+             << e.second.dxbcSize           << ","
+             << e.second.dxbcInstructions   << ","
+             << e.second.spirvWords         << ","
+             << e.second.translateTimeUs    << ","
+             << e.second.pipelineCount      << ","
+             << e.second.pipelineTimeUs     << std::endl;
+    }
+  }
+
+
+  void DxvkShaderStats::writeJson(
+          std::ostream&           stream,
+    const EntryList&              entries) {
+    stream << "[" << std::endl;
+
+    for (size_t i = 0; i < entries.size(); i++) {
+      const auto& e = entries[i];
+
+      stream << "  { \"shader\": \""          << e.first.toString()
+             << "\", \"dxbcSize\": "          << e.second.dxbcSize
+             << ", \"dxbcInstructions\": "    << e.second.dxbcInstructions
+             << ", \"spirvWords\": "          << e.second.spirvWords
+             << ", \"translateTimeUs\": "     << e.second.translateTimeUs
+             << ", \"pipelines\": "           << e.second.pipelineCount
+             << ", \"pipelineTimeUs\": "      << e.second.pipelineTimeUs
+             << (i + 1 < entries.size() ? " }," : " }") << std::endl;
+    }
+
+    stream << "]" << std::endl;
+  }
+
+}
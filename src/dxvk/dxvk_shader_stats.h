@@ -0,0 +1,133 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "dxvk_hash.h"
+#include "dxvk_shader_key.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Shader report format
+   */
+  enum class DxvkShaderStatsFormat : uint32_t {
+    Csv,
+    Json,
+  };
+
+
+  /**
+   * \brief Translation statistics for one shader
+   */
+  struct DxvkShaderStatsEntry {
+    uint64_t dxbcSize         = 0;  ///< Size of the DXBC code, in bytes
+    uint64_t dxbcInstructions = 0;  ///< Number of decoded DXBC instructions
+    uint64_t spirvWords       = 0;  ///< Size of the SPIR-V code, in words
+    uint64_t translateTimeUs  = 0;  ///< Translation time, in microseconds
+    uint64_t pipelineCount    = 0;  ///< Number of pipelines compiled
+    uint64_t pipelineTimeUs   = 0;  ///< Total compile time of those pipelines
+  };
+
+
+  /**
+   * \brief Shader statistics
+   *
+   * Collects per-shader translation and pipeline compile
+   * statistics, and writes them to a file when destroyed.
+   * Only shaders that the client API has registered are
+   * taken into account. This class is thread-safe.
+   */
+  class DxvkShaderStats : public RcObject {
+
+  public:
+
+    DxvkShaderStats(DxvkShaderStatsFormat format);
+
+    ~DxvkShaderStats();
+
+    /**
+     * \brief Records a translated shader
+     *
+     * \param [in] key Shader key
+     * \param [in] entry Translation statistics. The
+     *    pipeline statistics are ignored.
+     */
+    void addShader(
+      const DxvkShaderKey&          key,
+      const DxvkShaderStatsEntry&   entry);
+
+    /**
+     * \brief Records a compiled pipeline
+     *
+     * Since the compile time of a pipeline cannot be
+     * broken down further, the full time is added to
+     * each shader that is part of the pipeline.
+     * \param [in] key Shader key
+     * \param [in] timeUs Compile time, in microseconds
+     */
+    void addPipeline(
+      const DxvkShaderKey&          key,
+            uint64_t                timeUs);
+
+    /**
+     * \brief Registers an alias key
+     *
+     * Used when a shader is shared with an identical
+     * shader that was registered earlier. Pipelines
+     * recorded for the existing shader are added to
+     * the entry of the alias as well.
+     * \param [in] key Key of the existing shader
+     * \param [in] alias Key of the new shader
+     */
+    void addAlias(
+      const DxvkShaderKey&          key,
+      const DxvkShaderKey&          alias);
+
+    /**
+     * \brief Creates statistics object if enabled
+     *
+     * Statistics are enabled by setting \c DXVK_SHADER_STATS
+     * to either \c csv or \c json. The report will be written
+     * to the log directory.
+     * \returns Statistics object, or \c nullptr
+     */
+    static Rc<DxvkShaderStats> createFromEnv();
+
+  private:
+
+    using EntryList = std::vector<std::pair<DxvkShaderKey, DxvkShaderStatsEntry>>;
+
+    DxvkShaderStatsFormat m_format;
+
+    std::mutex            m_mutex;
+
+    std::unordered_map<
+      DxvkShaderKey,
+      DxvkShaderStatsEntry,
+      DxvkHash, DxvkEq>   m_entries;
+
+    std::unordered_multimap<
+      DxvkShaderKey,
+      DxvkShaderKey,
+      DxvkHash, DxvkEq>   m_aliases;
+
+    void addPipelineToEntry(
+      const DxvkShaderKey&          key,
+            uint64_t                timeUs);
+
+    static std::string getReportFileName(
+            DxvkShaderStatsFormat   format);
+
+    static void writeCsv(
+            std::ostream&           stream,
+      const EntryList&              entries);
+
+    static void writeJson(
+            std::ostream&           stream,
+      const EntryList&              entries);
+
+  };
+
+}
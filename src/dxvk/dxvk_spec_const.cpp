@@ -11,6 +11,7 @@ namespace dxvk {
   
   DxvkSpecConstantMap::DxvkSpecConstantMap() {
     SET_CONSTANT_ENTRY(DxvkSpecConstantId::RasterizerSampleCount, rasterizerSampleCount);
+    SET_CONSTANT_ENTRY(DxvkSpecConstantId::PushConstantStage,     pushConstantStage);
 
     for (uint32_t i = 0; i < MaxNumActiveBindings; i++)
       this->setBindingEntry(i);
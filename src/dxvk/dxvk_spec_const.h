@@ -18,6 +18,7 @@ namespace dxvk {
    */
   struct DxvkSpecConstantData {
     uint32_t rasterizerSampleCount;
+    uint32_t pushConstantStage;
     uint32_t outputMappings[MaxNumRenderTargets * 4];
     VkBool32 activeBindings[MaxNumActiveBindings];
   };
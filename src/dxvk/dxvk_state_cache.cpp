@@ -7,6 +7,9 @@ namespace dxvk {
   static const Sha1Hash       g_nullHash      = Sha1Hash::compute(nullptr, 0);
   static const DxvkShaderKey  g_nullShaderKey = DxvkShaderKey();
 
+  // Used for pipelines that the application is about to use
+  static const uint64_t       g_promotedPriority = ~0ull;
+
   bool DxvkStateCacheKey::eq(const DxvkStateCacheKey& key) const {
     return this->vs.eq(key.vs)
         && this->tcs.eq(key.tcs)
@@ -79,6 +82,11 @@ namespace dxvk {
       m_workerThreads[i].set_priority(ThreadPriority::Lowest);
     }
     
+    // Compute pipelines are cheap to compile, but stall the
+    // application just as much, so use a dedicated thread
+    m_computeThread = dxvk::thread([this] () { computeFunc(); });
+    m_computeThread.set_priority(ThreadPriority::Low);
+    
     m_writerThread = dxvk::thread([this] () { writerFunc(); });
   }
   
@@ -90,12 +98,15 @@ namespace dxvk {
       m_stopThreads.store(true);
 
       m_workerCond.notify_all();
+      m_computeCond.notify_all();
       m_writerCond.notify_all();
     }
 
     for (auto& worker : m_workerThreads)
       worker.join();
     
+    m_computeThread.join();
+    
     m_writerThread.join();
   }
 
@@ -113,8 +124,10 @@ namespace dxvk {
     for (auto e = entries.first; e != entries.second; e++) {
       const DxvkStateCacheEntry& entry = m_entries[e->second];
 
-      if (entry.format.matches(format) && entry.gpState == state)
+      if (entry.format.matches(format) && entry.gpState == state) {
+        recordEntryUsage(e->second);
         return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
@@ -122,7 +135,7 @@ namespace dxvk {
 
     m_writerQueue.push({ shaders, state,
       DxvkComputePipelineStateInfo(),
-      format, g_nullHash });
+      format, { m_session, 1 }, g_nullHash });
     m_writerCond.notify_one();
   }
 
@@ -137,8 +150,10 @@ namespace dxvk {
     auto entries = m_entryMap.equal_range(shaders);
 
     for (auto e = entries.first; e != entries.second; e++) {
-      if (m_entries[e->second].cpState == state)
+      if (m_entries[e->second].cpState == state) {
+        recordEntryUsage(e->second);
         return;
+      }
     }
 
     // Queue a job to write this pipeline to the cache
@@ -146,14 +161,14 @@ namespace dxvk {
 
     m_writerQueue.push({ shaders,
       DxvkGraphicsPipelineStateInfo(), state,
-      DxvkRenderPassFormat(), g_nullHash });
+      DxvkRenderPassFormat(), { m_session, 1 }, g_nullHash });
     m_writerCond.notify_one();
   }
 
 
-  void DxvkStateCache::registerShader(const Rc<DxvkShader>& shader) {
-    DxvkShaderKey key = shader->getShaderKey();
-
+  void DxvkStateCache::registerShader(
+    const Rc<DxvkShader>&           shader,
+    const DxvkShaderKey&            key) {
     if (key.eq(g_nullShaderKey))
       return;
     
@@ -163,11 +178,14 @@ namespace dxvk {
 
     // Deferred lock, don't stall workers unless we have to
     std::unique_lock<std::mutex> workerLock;
+    bool hasComputeItems = false;
+    bool hasWorkerItems  = false;
 
     auto pipelines = m_pipelineMap.equal_range(key);
 
     for (auto p = pipelines.first; p != pipelines.second; p++) {
       WorkerItem item;
+      item.key = p->second;
 
       if (!getShaderByKey(p->second.vs,  item.vs)
        || !getShaderByKey(p->second.tcs, item.tcs)
@@ -180,16 +198,46 @@ namespace dxvk {
       if (!workerLock)
         workerLock = std::unique_lock<std::mutex>(m_workerLock);
       
-      m_workerQueue.push(item);
+      // Compute pipelines only depend on the compute shader
+      // itself, so all entries share the same shader set.
+      // Compile them right away on the compute thread.
+      if (item.cs != nullptr) {
+        m_computeQueue.push(item);
+        hasComputeItems = true;
+        break;
+      }
+
+      // Pipelines that were used recently or frequently
+      // in previous sessions will be compiled first
+      if (m_workerItems.insert({ p->second, item }).second) {
+        m_workerQueue.push({ p->second,
+          getPipelinePriority(p->second),
+          m_workerSequence++ });
+        hasWorkerItems = true;
+      }
     }
 
-    if (workerLock)
+    if (hasComputeItems)
+      m_computeCond.notify_one();
+
+    if (hasWorkerItems)
       m_workerCond.notify_all();
   }
 
 
-  DxvkShaderKey DxvkStateCache::getShaderKey(const Rc<DxvkShader>& shader) const {
-    return shader != nullptr ? shader->getShaderKey() : g_nullShaderKey;
+  void DxvkStateCache::promotePipeline(const DxvkStateCacheKey& shaders) {
+    std::unique_lock<std::mutex> workerLock(m_workerLock);
+
+    // Nothing to do if the workers have already picked up
+    // the shader set, or if it is not in the cache at all.
+    // Otherwise, queue a duplicate with maximum priority.
+    if (m_workerItems.find(shaders) == m_workerItems.end())
+      return;
+
+    m_workerQueue.push({ shaders,
+      g_promotedPriority,
+      m_workerSequence++ });
+    m_workerCond.notify_one();
   }
 
 
@@ -223,14 +271,70 @@ namespace dxvk {
   }
 
 
+  bool DxvkStateCache::mergeEntryUsage(
+    const DxvkStateCacheEntry&      entry) {
+    auto entries = m_entryMap.equal_range(entry.shaders);
+
+    for (auto e = entries.first; e != entries.second; e++) {
+      DxvkStateCacheEntry& existing = m_entries[e->second];
+
+      if (existing.format.matches(entry.format)
+       && existing.gpState == entry.gpState
+       && existing.cpState == entry.cpState) {
+        existing.usage.session = std::max(existing.usage.session, entry.usage.session);
+        existing.usage.count   = std::max(existing.usage.count,   entry.usage.count);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+
+  void DxvkStateCache::recordEntryUsage(
+          size_t                    entryId) {
+    std::unique_lock<std::mutex> entryLock(m_entryLock);
+    DxvkStateCacheEntry& entry = m_entries[entryId];
+
+    if (entry.usage.session == m_session)
+      return;
+    
+    entry.usage.session = m_session;
+    entry.usage.count  += 1;
+
+    // Append a copy of the entry with updated usage info.
+    // It will be merged with the original one when reading
+    // the cache file, so we don't need to rewrite the file.
+    WriterItem item = entry;
+    entryLock.unlock();
+
+    std::unique_lock<std::mutex> writerLock(m_writerLock);
+    m_writerQueue.push(item);
+    m_writerCond.notify_one();
+  }
+
+
+  uint64_t DxvkStateCache::getPipelinePriority(
+    const DxvkStateCacheKey&        key) const {
+    // Prioritize by the most recent session in which any of
+    // the state vectors was used, then by usage frequency.
+    uint64_t priority = 0;
+
+    auto entries = m_entryMap.equal_range(key);
+
+    for (auto e = entries.first; e != entries.second; e++) {
+      const DxvkStateCacheUsage& usage = m_entries[e->second].usage;
+      priority = std::max(priority, (uint64_t(usage.session) << 32) | usage.count);
+    }
+
+    return priority;
+  }
+
+
   void DxvkStateCache::compilePipelines(const WorkerItem& item) {
-    DxvkStateCacheKey key;
-    key.vs  = getShaderKey(item.vs);
-    key.tcs = getShaderKey(item.tcs);
-    key.tes = getShaderKey(item.tes);
-    key.gs  = getShaderKey(item.gs);
-    key.fs  = getShaderKey(item.fs);
-    key.cs  = getShaderKey(item.cs);
+    // Shaders may have been registered under an alias key, so
+    // the entries must be looked up with the original key
+    const DxvkStateCacheKey& key = item.key;
 
     if (item.cs == nullptr) {
       auto pipeline = m_pipeManager->createGraphicsPipeline(
@@ -241,7 +345,7 @@ namespace dxvk {
         const auto& entry = m_entries[e->second];
 
         auto rp = m_passManager->getRenderPass(entry.format);
-        pipeline->getPipelineHandle(entry.gpState, *rp);
+        pipeline->compilePipeline(entry.gpState, *rp);
       }
     } else {
       auto pipeline = m_pipeManager->createComputePipeline(item.cs);
@@ -249,7 +353,7 @@ namespace dxvk {
 
       for (auto e = entries.first; e != entries.second; e++) {
         const auto& entry = m_entries[e->second];
-        pipeline->getPipelineHandle(entry.cpState);
+        pipeline->compilePipeline(entry.cpState);
       }
     }
   }
@@ -274,15 +378,14 @@ namespace dxvk {
       return false;
     }
 
-    // Struct size hasn't changed between v2/v3
-    if (curHeader.entrySize != newHeader.entrySize) {
-      Logger::warn("DXVK: State cache entry size changed");
+    // Discard caches of unsupported versions
+    if (curHeader.version < 2 || curHeader.version > newHeader.version) {
+      Logger::warn("DXVK: State cache out of date");
       return false;
     }
 
-    // Discard caches of unsupported versions
-    if (curHeader.version != 2 && curHeader.version != 3) {
-      Logger::warn("DXVK: State cache out of date");
+    if (curHeader.entrySize != getCacheEntrySize(curHeader.version)) {
+      Logger::warn("DXVK: State cache entry size changed");
       return false;
     }
 
@@ -294,14 +397,28 @@ namespace dxvk {
     // If we encounter invalid entries, we should
     // regenerate the entire state cache file.
     uint32_t numInvalidEntries = 0;
+    uint32_t numUsageEntries   = 0;
 
     while (ifile) {
       DxvkStateCacheEntry entry;
 
-      if (readCacheEntry(ifile, entry)) {
+      bool valid = curHeader.version < 4
+        ? readCacheEntryV3(ifile, entry)
+        : readCacheEntry  (ifile, entry);
+
+      if (valid) {
         if (curHeader.version == 2)
           convertEntryV2(entry);
         
+        m_session = std::max(m_session, entry.usage.session + 1);
+
+        // Entries that were appended in order to update
+        // the usage info of an existing entry are merged
+        if (mergeEntryUsage(entry)) {
+          numUsageEntries += 1;
+          continue;
+        }
+
         size_t entryId = m_entries.size();
         m_entries.push_back(entry);
 
@@ -328,15 +445,37 @@ namespace dxvk {
         " invalid state cache entries"));
       return false;
     }
+
+    // Compact the file if usage updates make up
+    // a significant portion of the cache file
+    if (numUsageEntries > m_entries.size()) {
+      Logger::info(str::format(
+        "DXVK: Merged ", numUsageEntries,
+        " state cache usage entries"));
+      return false;
+    }
     
     // Rewrite entire state cache if it is outdated
     return curHeader.version == newHeader.version;
   }
 
 
+  size_t DxvkStateCache::getCacheEntrySize(
+          uint32_t                  version) {
+    // Struct size hasn't changed between v2/v3,
+    // v4 added usage info to each cache entry
+    if (version < 2 || version > DxvkStateCacheHeader().version)
+      return 0;
+
+    return version < 4
+      ? sizeof(DxvkStateCacheEntryV3)
+      : sizeof(DxvkStateCacheEntry);
+  }
+
+
   bool DxvkStateCache::readCacheHeader(
           std::istream&             stream,
-          DxvkStateCacheHeader&     header) const {
+          DxvkStateCacheHeader&     header) {
     DxvkStateCacheHeader expected;
 
     auto data = reinterpret_cast<char*>(&header);
@@ -356,7 +495,7 @@ namespace dxvk {
 
   bool DxvkStateCache::readCacheEntry(
           std::istream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
+          DxvkStateCacheEntry&      entry) {
     auto data = reinterpret_cast<char*>(&entry);
     auto size = sizeof(DxvkStateCacheEntry);
 
@@ -369,9 +508,33 @@ namespace dxvk {
   }
 
 
+  bool DxvkStateCache::readCacheEntryV3(
+          std::istream&             stream, 
+          DxvkStateCacheEntry&      entry) {
+    DxvkStateCacheEntryV3 legacy;
+
+    auto data = reinterpret_cast<char*>(&legacy);
+    auto size = sizeof(DxvkStateCacheEntryV3);
+
+    if (!stream.read(data, size))
+      return false;
+    
+    Sha1Hash expectedHash = std::exchange(legacy.hash, g_nullHash);
+    Sha1Hash computedHash = Sha1Hash::compute(legacy);
+
+    entry.shaders = legacy.shaders;
+    entry.gpState = legacy.gpState;
+    entry.cpState = legacy.cpState;
+    entry.format  = legacy.format;
+    entry.usage   = DxvkStateCacheUsage();
+    entry.hash    = g_nullHash;
+    return expectedHash == computedHash;
+  }
+
+
   void DxvkStateCache::writeCacheEntry(
           std::ostream&             stream, 
-          DxvkStateCacheEntry&      entry) const {
+          DxvkStateCacheEntry&      entry) {
     entry.hash = Sha1Hash::compute(entry);
 
     auto data = reinterpret_cast<const char*>(&entry);
@@ -383,7 +546,7 @@ namespace dxvk {
 
 
   bool DxvkStateCache::convertEntryV2(
-          DxvkStateCacheEntry&      entry) const {
+          DxvkStateCacheEntry&      entry) {
     // Semantics changed:
     // v2: rsDepthClampEnable
     // v3: rsDepthClipEnable
@@ -412,8 +575,41 @@ namespace dxvk {
         if (m_workerQueue.size() == 0)
           break;
         
-        item = m_workerQueue.front();
+        // Promoted shader sets are queued twice, so the
+        // item may already have been processed by now
+        auto entry = m_workerItems.find(m_workerQueue.top().key);
         m_workerQueue.pop();
+
+        if (entry == m_workerItems.end())
+          continue;
+
+        item = std::move(entry->second);
+        m_workerItems.erase(entry);
+      }
+
+      compilePipelines(item);
+    }
+  }
+
+
+  void DxvkStateCache::computeFunc() {
+    env::setThreadName("dxvk-shader-cs");
+
+    while (!m_stopThreads.load()) {
+      WorkerItem item;
+
+      { std::unique_lock<std::mutex> lock(m_workerLock);
+
+        m_computeCond.wait(lock, [this] () {
+          return m_computeQueue.size()
+              || m_stopThreads.load();
+        });
+
+        if (m_computeQueue.size() == 0)
+          break;
+        
+        item = m_computeQueue.front();
+        m_computeQueue.pop();
       }
 
       compilePipelines(item);
@@ -36,6 +36,20 @@ namespace dxvk {
   };
 
   
+  /**
+   * \brief State entry usage info
+   * 
+   * Stores the most recent session in which the
+   * application used the pipeline, as well as the
+   * number of sessions in which it has been used.
+   * Sessions are numbered in ascending order.
+   */
+  struct DxvkStateCacheUsage {
+    uint32_t session = 0;
+    uint32_t count   = 0;
+  };
+
+
   /**
    * \brief State entry
    * 
@@ -45,6 +59,22 @@ namespace dxvk {
    * that is used as a check sum to verify integrity.
    */
   struct DxvkStateCacheEntry {
+    DxvkStateCacheKey             shaders;
+    DxvkGraphicsPipelineStateInfo gpState;
+    DxvkComputePipelineStateInfo  cpState;
+    DxvkRenderPassFormat          format;
+    DxvkStateCacheUsage           usage;
+    Sha1Hash                      hash;
+  };
+
+
+  /**
+   * \brief Legacy state entry
+   * 
+   * Entry layout used by state cache versions 2
+   * and 3, which did not store usage info.
+   */
+  struct DxvkStateCacheEntryV3 {
     DxvkStateCacheKey             shaders;
     DxvkGraphicsPipelineStateInfo gpState;
     DxvkComputePipelineStateInfo  cpState;
@@ -62,7 +92,7 @@ namespace dxvk {
    */
   struct DxvkStateCacheHeader {
     char     magic[4]   = { 'D', 'X', 'V', 'K' };
-    uint32_t version    = 3;
+    uint32_t version    = 4;
     uint32_t entrySize  = sizeof(DxvkStateCacheEntry);
   };
 
@@ -122,15 +152,105 @@ namespace dxvk {
      * compiler, and starts compiling all pipelines
      * for which all shaders become available.
      * \param [in] shader The shader to add
+     * \param [in] key Key to register the shader with.
+     *    Differs from the shader's own key if the shader
+     *    is shared with another, identical shader.
      */
     void registerShader(
-      const Rc<DxvkShader>&                 shader);
+      const Rc<DxvkShader>&                 shader,
+      const DxvkShaderKey&                  key);
+
+    /**
+     * \brief Moves a pipeline to the front of the queue
+     * 
+     * Should be called when the application is about to
+     * compile a pipeline synchronously. If the worker
+     * threads have not processed the given shader set
+     * yet, they will do so before any other pipeline.
+     * Only applies to graphics pipelines, since compute
+     * pipelines are compiled as soon as the shader is
+     * registered.
+     * \param [in] shaders Shader keys
+     */
+    void promotePipeline(
+      const DxvkStateCacheKey&              shaders);
+
+    /**
+     * \brief Computes entry size for a given version
+     * 
+     * \param [in] version State cache version
+     * \returns Size of a cache entry in bytes, or
+     *    zero if the version is not supported
+     */
+    static size_t getCacheEntrySize(
+            uint32_t                  version);
+
+    /**
+     * \brief Reads state cache file header
+     * 
+     * Only checks the magic number. Callers must
+     * validate the version and entry size.
+     * \param [in] stream Input stream
+     * \param [out] header File header
+     * \returns \c true on success
+     */
+    static bool readCacheHeader(
+            std::istream&             stream,
+            DxvkStateCacheHeader&     header);
+
+    /**
+     * \brief Reads a state cache entry
+     * 
+     * Reads an entry of the current version and
+     * verifies its checksum.
+     * \param [in] stream Input stream
+     * \param [out] entry Cache entry
+     * \returns \c true if the entry is valid
+     */
+    static bool readCacheEntry(
+            std::istream&             stream, 
+            DxvkStateCacheEntry&      entry);
+
+    /**
+     * \brief Reads a legacy state cache entry
+     * 
+     * Reads a v2 or v3 entry and converts it to the
+     * current layout. v2 entries additionally need
+     * to be fixed up with \ref convertEntryV2.
+     * \param [in] stream Input stream
+     * \param [out] entry Cache entry
+     * \returns \c true if the entry is valid
+     */
+    static bool readCacheEntryV3(
+            std::istream&             stream, 
+            DxvkStateCacheEntry&      entry);
+    
+    /**
+     * \brief Writes a state cache entry
+     * 
+     * Computes the entry's checksum before writing.
+     * \param [in] stream Output stream
+     * \param [in] entry Cache entry
+     */
+    static void writeCacheEntry(
+            std::ostream&             stream, 
+            DxvkStateCacheEntry&      entry);
+    
+    /**
+     * \brief Converts a v2 entry to the current version
+     * 
+     * \param [in,out] entry Cache entry
+     * \returns \c true on success
+     */
+    static bool convertEntryV2(
+            DxvkStateCacheEntry&      entry);
 
   private:
 
     using WriterItem = DxvkStateCacheEntry;
 
     struct WorkerItem {
+      DxvkStateCacheKey key;
       Rc<DxvkShader> vs;
       Rc<DxvkShader> tcs;
       Rc<DxvkShader> tes;
@@ -139,12 +259,26 @@ namespace dxvk {
       Rc<DxvkShader> cs;
     };
 
+    struct WorkerQueueEntry {
+      DxvkStateCacheKey key;
+      uint64_t          priority;
+      uint64_t          sequence;
+
+      bool operator < (const WorkerQueueEntry& other) const {
+        if (priority != other.priority)
+          return priority < other.priority;
+        return sequence > other.sequence;
+      }
+    };
+
     DxvkPipelineManager*              m_pipeManager;
     DxvkRenderPassPool*               m_passManager;
 
     std::vector<DxvkStateCacheEntry>  m_entries;
     std::atomic<bool>                 m_stopThreads = { false };
 
+    uint32_t                          m_session = 1;
+
     std::mutex                        m_entryLock;
 
     std::unordered_multimap<
@@ -161,17 +295,24 @@ namespace dxvk {
 
     std::mutex                        m_workerLock;
     std::condition_variable           m_workerCond;
-    std::queue<WorkerItem>            m_workerQueue;
+    std::priority_queue<
+      WorkerQueueEntry>               m_workerQueue;
     std::vector<dxvk::thread>         m_workerThreads;
+    uint64_t                          m_workerSequence = 0;
+
+    std::unordered_map<
+      DxvkStateCacheKey, WorkerItem,
+      DxvkHash, DxvkEq> m_workerItems;
+
+    std::condition_variable           m_computeCond;
+    std::queue<WorkerItem>            m_computeQueue;
+    dxvk::thread                      m_computeThread;
 
     std::mutex                        m_writerLock;
     std::condition_variable           m_writerCond;
     std::queue<WriterItem>            m_writerQueue;
     dxvk::thread                      m_writerThread;
 
-    DxvkShaderKey getShaderKey(
-      const Rc<DxvkShader>&           shader) const;
-
     bool getShaderByKey(
       const DxvkShaderKey&            key,
             Rc<DxvkShader>&           shader) const;
@@ -184,28 +325,24 @@ namespace dxvk {
       const DxvkShaderKey&            shader,
       const DxvkStateCacheKey&        key);
 
+    bool mergeEntryUsage(
+      const DxvkStateCacheEntry&      entry);
+
+    void recordEntryUsage(
+            size_t                    entryId);
+
+    uint64_t getPipelinePriority(
+      const DxvkStateCacheKey&        key) const;
+
     void compilePipelines(
       const WorkerItem&               item);
 
     bool readCacheFile();
 
-    bool readCacheHeader(
-            std::istream&             stream,
-            DxvkStateCacheHeader&     header) const;
-
-    bool readCacheEntry(
-            std::istream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
-    
-    void writeCacheEntry(
-            std::ostream&             stream, 
-            DxvkStateCacheEntry&      entry) const;
-    
-    bool convertEntryV2(
-            DxvkStateCacheEntry&      entry) const;
-    
     void workerFunc();
 
+    void computeFunc();
+
     void writerFunc();
 
     std::string getCacheFileName() const;
@@ -31,4 +31,28 @@ namespace dxvk {
       m_counters[i] = 0;
   }
   
+  
+  void DxvkTimeHistogram::addTime(uint64_t time) {
+    uint32_t bucket = 0;
+    
+    while (time >= getBucketLimit(bucket))
+      bucket += 1;
+    
+    m_buckets[bucket] += 1;
+  }
+  
+  
+  uint64_t DxvkTimeHistogram::getBucketLimit(uint32_t bucket) {
+    return bucket + 1 < BucketCount
+      ? 1000ull << bucket
+      : ~0ull;
+  }
+  
+  
+  std::string DxvkTimeHistogram::getBucketName(uint32_t bucket) {
+    return bucket + 1 < BucketCount
+      ? str::format("< ",  getBucketLimit(bucket)     / 1000, " ms")
+      : str::format(">= ", getBucketLimit(bucket - 1) / 1000, " ms");
+  }
+  
 }
@@ -17,8 +17,19 @@ namespace dxvk {
     MemoryAllocationCount,    ///< Number of memory allocations
     MemoryAllocated,          ///< Amount of memory allocated
     MemoryUsed,               ///< Amount of memory used
+    ShaderCodeCompressed,     ///< Compressed size of all shader code
+    ShaderCodeUncompressed,   ///< Uncompressed size of all shader code
+    ShaderCodeCached,         ///< Size of cached uncompressed shader code
     PipeCountGraphics,        ///< Number of graphics pipelines
     PipeCountCompute,         ///< Number of compute pipelines
+    PipeCompiledFull,         ///< Number of pipelines compiled without a base pipeline
+    PipeCompiledDerived,      ///< Number of pipelines compiled as derivatives
+    PipeCompileTimeFull,      ///< Time spent compiling full pipelines, in microseconds
+    PipeCompileTimeDerived,   ///< Time spent compiling derivative pipelines, in microseconds
+    PipeCompiledSync,         ///< Number of pipelines compiled on demand
+    PipeCompiledAsync,        ///< Number of pipelines compiled by state cache workers
+    PipeCompileTimeSync,      ///< Time spent compiling pipelines on demand, in microseconds
+    PipeCompileTimeAsync,     ///< Time spent compiling pipelines in the background, in microseconds
     QueueSubmitCount,         ///< Number of command buffer submissions
     QueuePresentCount,        ///< Number of present calls / frames
     NumCounters,              ///< Number of counters available
@@ -107,4 +118,72 @@ namespace dxvk {
     
   };
   
+  
+  /**
+   * \brief Pipeline compile type
+   * 
+   * Pipelines compiled on demand stall the thread that
+   * records the command buffer and may cause stutter,
+   * whereas pipelines compiled by the state cache
+   * workers are compiled in the background.
+   */
+  enum class DxvkPipelineCompileType : uint32_t {
+    Sync  = 0,  ///< Compiled on demand
+    Async = 1,  ///< Compiled by state cache workers
+  };
+  
+  
+  /**
+   * \brief Time histogram
+   * 
+   * Sorts durations into buckets with exponentially
+   * growing bounds. The first bucket stores durations
+   * of less than a millisecond, the last bucket stores
+   * all durations that do not fit into any other.
+   */
+  class DxvkTimeHistogram {
+    
+  public:
+    
+    constexpr static uint32_t BucketCount = 8;
+    
+    /**
+     * \brief Adds a duration to the histogram
+     * \param [in] time Duration, in microseconds
+     */
+    void addTime(uint64_t time);
+    
+    /**
+     * \brief Number of durations in a bucket
+     * 
+     * \param [in] bucket Bucket index
+     * \returns Number of durations in the bucket
+     */
+    uint64_t getCount(uint32_t bucket) const {
+      return m_buckets[bucket];
+    }
+    
+    /**
+     * \brief Upper bound of a bucket
+     * 
+     * \param [in] bucket Bucket index
+     * \returns Exclusive upper bound, in microseconds,
+     *    or \c ~0 for the last bucket
+     */
+    static uint64_t getBucketLimit(uint32_t bucket);
+    
+    /**
+     * \brief Human-readable bucket name
+     * 
+     * \param [in] bucket Bucket index
+     * \returns Bucket name, e.g. \c "< 4 ms"
+     */
+    static std::string getBucketName(uint32_t bucket);
+    
+  private:
+    
+    std::array<uint64_t, BucketCount> m_buckets = { };
+    
+  };
+  
 }
@@ -19,6 +19,7 @@ namespace dxvk::hud {
     StatPipelines     = 5,
     StatMemory        = 6,
     DxvkVersion       = 7,
+    StatCompileTimes  = 8,
   };
   
   using HudElements = Flags<HudElement>;
@@ -20,6 +20,11 @@ namespace dxvk::hud {
     DxvkStatCounters nextCounters = device->getStatCounters();
     m_diffCounters = nextCounters.diff(m_prevCounters);
     m_prevCounters = nextCounters;
+    
+    if (m_elements.test(HudElement::StatCompileTimes)) {
+      m_syncCompileTimes  = device->getCompileTimeHistogram(DxvkPipelineCompileType::Sync);
+      m_asyncCompileTimes = device->getCompileTimeHistogram(DxvkPipelineCompileType::Async);
+    }
   }
   
   
@@ -36,6 +41,9 @@ namespace dxvk::hud {
     if (m_elements.test(HudElement::StatPipelines))
       position = this->printPipelineStats(context, renderer, position);
     
+    if (m_elements.test(HudElement::StatCompileTimes))
+      position = this->printCompileTimeStats(context, renderer, position);
+    
     if (m_elements.test(HudElement::StatMemory))
       position = this->printMemoryStats(context, renderer, position);
     
@@ -101,8 +109,16 @@ namespace dxvk::hud {
     const uint64_t gpCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCountGraphics);
     const uint64_t cpCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCountCompute);
     
+    // Average compile time per pipeline, in microseconds
+    const uint64_t fullCount   = m_prevCounters.getCtr(DxvkStatCounter::PipeCompiledFull);
+    const uint64_t derivCount  = m_prevCounters.getCtr(DxvkStatCounter::PipeCompiledDerived);
+    const uint64_t fullTime    = m_prevCounters.getCtr(DxvkStatCounter::PipeCompileTimeFull)    / std::max<uint64_t>(fullCount,  1);
+    const uint64_t derivTime   = m_prevCounters.getCtr(DxvkStatCounter::PipeCompileTimeDerived) / std::max<uint64_t>(derivCount, 1);
+    
     const std::string strGpCount = str::format("Graphics pipelines: ", gpCount);
     const std::string strCpCount = str::format("Compute pipelines:  ", cpCount);
+    const std::string strGpFull  = str::format("  Full:       ", fullCount,  " (", fullTime  / 1000, ".", (fullTime  / 100) % 10, " ms avg)");
+    const std::string strGpDeriv = str::format("  Derivative: ", derivCount, " (", derivTime / 1000, ".", (derivTime / 100) % 10, " ms avg)");
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
@@ -112,9 +128,59 @@ namespace dxvk::hud {
     renderer.drawText(context, 16.0f,
       { position.x, position.y + 20.0f },
       { 1.0f, 1.0f, 1.0f, 1.0f },
+      strGpFull);
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strGpDeriv);
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 60.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
       strCpCount);
     
-    return { position.x, position.y + 44.0f };
+    return { position.x, position.y + 84.0f };
+  }
+  
+  
+  HudPos HudStats::printCompileTimeStats(
+    const Rc<DxvkContext>&  context,
+          HudRenderer&      renderer,
+          HudPos            position) {
+    const uint64_t syncCount  = m_prevCounters.getCtr(DxvkStatCounter::PipeCompiledSync);
+    const uint64_t asyncCount = m_prevCounters.getCtr(DxvkStatCounter::PipeCompiledAsync);
+    const uint64_t syncTime   = m_prevCounters.getCtr(DxvkStatCounter::PipeCompileTimeSync)  / 1000;
+    const uint64_t asyncTime  = m_prevCounters.getCtr(DxvkStatCounter::PipeCompileTimeAsync) / 1000;
+    
+    const std::string strSync  = str::format("On demand:  ", syncCount,  " (", syncTime,  " ms)");
+    const std::string strAsync = str::format("Background: ", asyncCount, " (", asyncTime, " ms)");
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strSync);
+    
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 20.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strAsync);
+    
+    // One line per histogram bucket, showing on-demand
+    // compiles first since those are the ones that stall
+    for (uint32_t i = 0; i < DxvkTimeHistogram::BucketCount; i++) {
+      const std::string strBucket = str::format("  ",
+        DxvkTimeHistogram::getBucketName(i), ": ",
+        m_syncCompileTimes.getCount(i), " / ",
+        m_asyncCompileTimes.getCount(i));
+      
+      renderer.drawText(context, 16.0f,
+        { position.x, position.y + 40.0f + 20.0f * float(i) },
+        { 1.0f, 1.0f, 1.0f, 1.0f },
+        strBucket);
+    }
+    
+    return { position.x, position.y + 44.0f + 20.0f * float(DxvkTimeHistogram::BucketCount) };
   }
   
   
@@ -122,13 +188,19 @@ namespace dxvk::hud {
     const Rc<DxvkContext>&  context,
           HudRenderer&      renderer,
           HudPos            position) {
+    constexpr uint64_t kib = 1024;
     constexpr uint64_t mib = 1024 * 1024;
     
     const uint64_t memAllocated = m_prevCounters.getCtr(DxvkStatCounter::MemoryAllocated);
     const uint64_t memUsed      = m_prevCounters.getCtr(DxvkStatCounter::MemoryUsed);
+    const uint64_t codeSize     = m_prevCounters.getCtr(DxvkStatCounter::ShaderCodeCompressed);
+    const uint64_t codeSizeRaw  = m_prevCounters.getCtr(DxvkStatCounter::ShaderCodeUncompressed);
+    const uint64_t codeCached   = m_prevCounters.getCtr(DxvkStatCounter::ShaderCodeCached);
     
     const std::string strMemAllocated = str::format("Memory allocated: ", memAllocated / mib, " MB");
     const std::string strMemUsed      = str::format("Memory used:      ", memUsed      / mib, " MB");
+    const std::string strShaderCode   = str::format("Shader code:      ", codeSize / kib, " kB (",
+      codeSizeRaw / kib, " kB uncompressed, ", codeCached / kib, " kB cached)");
     
     renderer.drawText(context, 16.0f,
       { position.x, position.y },
@@ -140,7 +212,12 @@ namespace dxvk::hud {
       { 1.0f, 1.0f, 1.0f, 1.0f },
       strMemUsed);
     
-    return { position.x, position.y + 44.0f };
+    renderer.drawText(context, 16.0f,
+      { position.x, position.y + 40.0f },
+      { 1.0f, 1.0f, 1.0f, 1.0f },
+      strShaderCode);
+    
+    return { position.x, position.y + 64.0f };
   }
   
   
@@ -149,6 +226,7 @@ namespace dxvk::hud {
       HudElement::StatDrawCalls,
       HudElement::StatSubmissions,
       HudElement::StatPipelines,
+      HudElement::StatCompileTimes,
       HudElement::StatMemory);
   }
   
@@ -36,6 +36,9 @@ namespace dxvk::hud {
     DxvkStatCounters  m_prevCounters;
     DxvkStatCounters  m_diffCounters;
     
+    DxvkTimeHistogram m_syncCompileTimes;
+    DxvkTimeHistogram m_asyncCompileTimes;
+    
     HudPos printDrawCallStats(
       const Rc<DxvkContext>&  context,
             HudRenderer&      renderer,
@@ -51,6 +54,11 @@ namespace dxvk::hud {
             HudRenderer&      renderer,
             HudPos            position);
     
+    HudPos printCompileTimeStats(
+      const Rc<DxvkContext>&  context,
+            HudRenderer&      renderer,
+            HudPos            position);
+    
     HudPos printMemoryStats(
       const Rc<DxvkContext>&  context,
             HudRenderer&      renderer,
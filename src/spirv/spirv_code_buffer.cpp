@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 #include <cstring>
 
@@ -36,6 +37,9 @@ namespace dxvk {
   
   void SpirvCodeBuffer::append(const SpirvCodeBuffer& other) {
     if (other.size() != 0) {
+      this->closeGap();
+      other.closeGap();
+      
       const size_t size = m_code.size();
       m_code.resize(size + other.m_code.size());
       
@@ -48,9 +52,35 @@ namespace dxvk {
   }
   
   
+  void SpirvCodeBuffer::reserve(size_t wordCount) {
+    m_code.reserve(wordCount + m_gapSize);
+  }
+  
+  
   void SpirvCodeBuffer::putWord(uint32_t word) {
-    m_code.insert(m_code.begin() + m_ptr, word);
-    m_ptr += 1;
+    // Appending does not need a gap. Any existing gap
+    // stays where it is, so that code can be inserted
+    // at the same location again without moving code.
+    if (m_ptr == this->wordCount()) {
+      m_code.push_back(word);
+      m_ptr += 1;
+      return;
+    }
+    
+    if (m_gapPtr != m_ptr)
+      this->moveGap(m_ptr);
+    
+    // Grow the gap along with the buffer, so that
+    // inserting a word takes amortized constant time
+    if (!m_gapSize) {
+      m_gapSize = std::max<size_t>(m_code.size() / 4, 64);
+      m_code.insert(m_code.begin() + m_ptr, m_gapSize, 0u);
+    }
+    
+    m_code[m_ptr] = word;
+    m_ptr     += 1;
+    m_gapPtr  += 1;
+    m_gapSize -= 1;
   }
   
   
@@ -123,9 +153,42 @@ namespace dxvk {
   
   
   void SpirvCodeBuffer::store(std::ostream& stream) const {
+    this->closeGap();
+    
     stream.write(
       reinterpret_cast<const char*>(m_code.data()),
       sizeof(uint32_t) * m_code.size());
   }
   
-}
\ No newline at end of file
+  
+  
+  void SpirvCodeBuffer::moveGap(size_t ptr) {
+    if (!m_gapSize) {
+      m_gapPtr = ptr;
+      return;
+    }
+    
+    // Move the words between the old and the new
+    // gap location to the other side of the gap
+    auto base = m_code.begin();
+    
+    if (ptr < m_gapPtr)
+      std::move_backward(base + ptr, base + m_gapPtr, base + m_gapPtr + m_gapSize);
+    else
+      std::move(base + m_gapPtr + m_gapSize, base + ptr + m_gapSize, base + m_gapPtr);
+    
+    m_gapPtr = ptr;
+  }
+  
+  
+  void SpirvCodeBuffer::closeGap() const {
+    if (!m_gapSize)
+      return;
+    
+    m_code.erase(
+      m_code.begin() + m_gapPtr,
+      m_code.begin() + m_gapPtr + m_gapSize);
+    m_gapSize = 0;
+  }
+  
+}
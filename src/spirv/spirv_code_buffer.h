@@ -15,6 +15,13 @@ namespace dxvk {
    * Helper class for generating SPIR-V shaders.
    * Stores arbitrary SPIR-V instructions in a
    * format that can be read by Vulkan drivers.
+   * 
+   * Code inserted in the middle of the buffer is
+   * written into a gap at the insertion pointer,
+   * so that the tail of the buffer only needs to
+   * be moved when the gap is full, rather than
+   * for every single word. The gap is removed
+   * before the code gets accessed.
    */
   class SpirvCodeBuffer {
     
@@ -34,15 +41,15 @@ namespace dxvk {
      * \brief Code data
      * \returns Code data
      */
-    const uint32_t* data() const { return m_code.data(); }
-          uint32_t* data()       { return m_code.data(); }
+    const uint32_t* data() const { closeGap(); return m_code.data(); }
+          uint32_t* data()       { closeGap(); return m_code.data(); }
     
     /**
      * \brief Code size, in bytes
      * \returns Code size, in bytes
      */
     size_t size() const {
-      return m_code.size() * sizeof(uint32_t);
+      return this->wordCount() * sizeof(uint32_t);
     }
     
     /**
@@ -53,6 +60,7 @@ namespace dxvk {
      * \returns Instruction iterator
      */
     SpirvInstructionIterator begin() {
+      closeGap();
       return SpirvInstructionIterator(
         m_code.data(), 0, m_code.size());
     }
@@ -77,6 +85,16 @@ namespace dxvk {
      */
     void append(const SpirvCodeBuffer& other);
     
+    /**
+     * \brief Reserves memory
+     * 
+     * Useful when the final size of the code
+     * buffer is known in advance, e.g. when
+     * concatenating multiple code buffers.
+     * \param [in] wordCount Number of words
+     */
+    void reserve(size_t wordCount);
+    
     /**
      * \brief Appends an 32-bit word to the buffer
      * \param [in] word The word to append
@@ -181,14 +199,28 @@ namespace dxvk {
      * this will restore default behaviour.
      */
     void endInsertion() {
-      m_ptr = m_code.size();
+      m_ptr = this->wordCount();
     }
     
   private:
     
-    std::vector<uint32_t> m_code;
+    mutable std::vector<uint32_t> m_code;
     size_t m_ptr = 0;
     
+    // Location and size of the gap, in words. The gap
+    // is created by inserting code and removed as soon
+    // as the code is accessed.
+    mutable size_t m_gapPtr  = 0;
+    mutable size_t m_gapSize = 0;
+    
+    size_t wordCount() const {
+      return m_code.size() - m_gapSize;
+    }
+    
+    void moveGap(size_t ptr);
+    
+    void closeGap() const;
+    
   };
   
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <algorithm>
+
+#include "spirv_compression.h"
+
+namespace dxvk {
+
+  SpirvCompressedBuffer:: SpirvCompressedBuffer() { }
+  SpirvCompressedBuffer::~SpirvCompressedBuffer() { }
+
+
+  SpirvCompressedBuffer::SpirvCompressedBuffer(
+    const SpirvCodeBuffer&  code)
+  : m_wordCount(code.size() / sizeof(uint32_t)) {
+    const uint32_t* words = code.data();
+
+    // Most words fit into one or two bytes
+    m_data.reserve(m_wordCount * 2);
+
+    // The header contains no instructions
+    uint32_t offset = std::min<uint32_t>(m_wordCount, 5);
+
+    for (uint32_t i = 0; i < offset; i++)
+      this->putWord(words[i]);
+
+    while (offset < m_wordCount) {
+      uint32_t opCode = words[offset] & 0xFFFF;
+      uint32_t length = words[offset] >> 16;
+
+      // The opcode is usually small, and storing it
+      // separately keeps the word count out of the
+      // high bits of the encoded value
+      this->putWord(opCode);
+      this->putWord(length);
+
+      uint32_t end = std::min(m_wordCount,
+        offset + std::max<uint32_t>(length, 1));
+
+      for (uint32_t i = offset + 1; i < end; i++)
+        this->putWord(words[i]);
+
+      offset = end;
+    }
+
+    m_data.shrink_to_fit();
+  }
+
+
+  SpirvCodeBuffer SpirvCompressedBuffer::decompress() const {
+    if (!m_wordCount)
+      return SpirvCodeBuffer();
+    
+    std::vector<uint32_t> words(m_wordCount);
+
+    const uint8_t* ptr = m_data.data();
+
+    uint32_t offset = std::min<uint32_t>(m_wordCount, 5);
+
+    for (uint32_t i = 0; i < offset; i++)
+      words[i] = getWord(ptr);
+
+    while (offset < m_wordCount) {
+      uint32_t opCode = getWord(ptr);
+      uint32_t length = getWord(ptr);
+
+      words[offset] = opCode | (length << 16);
+
+      uint32_t end = std::min(m_wordCount,
+        offset + std::max<uint32_t>(length, 1));
+
+      for (uint32_t i = offset + 1; i < end; i++)
+        words[i] = getWord(ptr);
+
+      offset = end;
+    }
+
+    return SpirvCodeBuffer(words.size(), words.data());
+  }
+
+
+  void SpirvCompressedBuffer::putWord(uint32_t word) {
+    while (word >= 0x80) {
+      m_data.push_back(uint8_t(word | 0x80));
+      word >>= 7;
+    }
+
+    m_data.push_back(uint8_t(word));
+  }
+
+
+  uint32_t SpirvCompressedBuffer::getWord(
+    const uint8_t*&         ptr) {
+    uint32_t word  = 0;
+    uint32_t shift = 0;
+
+    while (*ptr & 0x80) {
+      word  |= uint32_t(*(ptr++) & 0x7F) << shift;
+      shift += 7;
+    }
+
+    return word | (uint32_t(*(ptr++)) << shift);
+  }
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+
+#include "spirv_code_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief Compressed SPIR-V code buffer
+   *
+   * Stores SPIR-V code in a compact form that
+   * can be kept in memory for a long time, and
+   * decompressed whenever the code is needed.
+   *
+   * Each instruction is encoded as its opcode and
+   * word count, followed by its operands. All values
+   * are stored as variable-length integers with seven
+   * bits per byte, which works well for SPIR-V since
+   * most words are small IDs, enum values or counts.
+   */
+  class SpirvCompressedBuffer {
+
+  public:
+
+    SpirvCompressedBuffer();
+
+    explicit SpirvCompressedBuffer(
+      const SpirvCodeBuffer&  code);
+
+    ~SpirvCompressedBuffer();
+
+    /**
+     * \brief Compressed size, in bytes
+     * \returns Compressed size, in bytes
+     */
+    size_t size() const {
+      return m_data.size();
+    }
+
+    /**
+     * \brief Uncompressed code size, in bytes
+     * \returns Uncompressed code size, in bytes
+     */
+    size_t uncompressedSize() const {
+      return m_wordCount * sizeof(uint32_t);
+    }
+
+    /**
+     * \brief Decompresses the code
+     * \returns The uncompressed code
+     */
+    SpirvCodeBuffer decompress() const;
+
+  private:
+
+    uint32_t             m_wordCount = 0;
+    std::vector<uint8_t> m_data;
+
+    void putWord(uint32_t word);
+
+    static uint32_t getWord(
+      const uint8_t*&         ptr);
+
+  };
+
+}
@@ -1,9 +1,20 @@
+#include <array>
 #include <cstring>
 
 #include "spirv_module.h"
 
 namespace dxvk {
   
+  size_t SpirvTypeConstKeyHash::operator () (const SpirvTypeConstKey& key) const {
+    size_t hash = 0;
+    
+    for (uint32_t word : key.words)
+      hash ^= size_t(word) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+    
+    return hash;
+  }
+  
+  
   SpirvModule:: SpirvModule() {
     this->instImportGlsl450();
   }
@@ -15,19 +26,33 @@ namespace dxvk {
   
   
   SpirvCodeBuffer SpirvModule::compile() const {
+    const std::array<const SpirvCodeBuffer*, 11> sections = {{
+      &m_capabilities,
+      &m_extensions,
+      &m_instExt,
+      &m_memoryModel,
+      &m_entryPoints,
+      &m_execModeInfo,
+      &m_debugNames,
+      &m_annotations,
+      &m_typeConstDefs,
+      &m_variables,
+      &m_code,
+    }};
+    
+    // Allocate the final buffer only once
+    size_t wordCount = 5;
+    
+    for (auto section : sections)
+      wordCount += section->size() / sizeof(uint32_t);
+    
     SpirvCodeBuffer result;
+    result.reserve(wordCount);
     result.putHeader(m_id);
-    result.append(m_capabilities);
-    result.append(m_extensions);
-    result.append(m_instExt);
-    result.append(m_memoryModel);
-    result.append(m_entryPoints);
-    result.append(m_execModeInfo);
-    result.append(m_debugNames);
-    result.append(m_annotations);
-    result.append(m_typeConstDefs);
-    result.append(m_variables);
-    result.append(m_code);
+    
+    for (auto section : sections)
+      result.append(*section);
+    
     return result;
   }
   
@@ -2919,6 +2944,34 @@ namespace dxvk {
   }
 
 
+  uint32_t SpirvModule::opGroupNonUniformBroadcastFirst(
+          uint32_t                resultType,
+          uint32_t                execution,
+          uint32_t                value) {
+    uint32_t resultId = this->allocateId();
+
+    m_code.putIns(spv::OpGroupNonUniformBroadcastFirst, 5);
+    m_code.putWord(resultType);
+    m_code.putWord(resultId);
+    m_code.putWord(execution);
+    m_code.putWord(value);
+    return resultId;
+  }
+
+
+  uint32_t SpirvModule::opGroupNonUniformElect(
+          uint32_t                resultType,
+          uint32_t                execution) {
+    uint32_t resultId = this->allocateId();
+
+    m_code.putIns(spv::OpGroupNonUniformElect, 4);
+    m_code.putWord(resultType);
+    m_code.putWord(resultId);
+    m_code.putWord(execution);
+    return resultId;
+  }
+
+
   uint32_t SpirvModule::opGroupNonUniformLogicalAnd(
           uint32_t                resultType,
           uint32_t                execution,
@@ -3070,19 +3123,19 @@ namespace dxvk {
           spv::Op                 op, 
           uint32_t                argCount,
     const uint32_t*               argIds) {
-    // Since the type info is stored in the code buffer,
-    // we can use the code buffer to look up type IDs as
-    // well. Result IDs are always stored as argument 1.
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 2 + argCount;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(2 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(1);
-    }
+    SpirvTypeConstKey key;
+    key.words.reserve(1 + argCount);
+    key.words.push_back(op);
+    
+    for (uint32_t i = 0; i < argCount; i++)
+      key.words.push_back(argIds[i]);
+    
+    // Look up existing declarations by their opcode and
+    // operands rather than scanning the code buffer
+    auto entry = m_typeConstIds.find(key);
+    
+    if (entry != m_typeConstIds.end())
+      return entry->second;
     
     // Type not yet declared, create a new one.
     uint32_t resultId = this->allocateId();
@@ -3091,6 +3144,8 @@ namespace dxvk {
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    
+    m_typeConstIds.insert({ std::move(key), resultId });
     return resultId;
   }
   
@@ -3100,18 +3155,19 @@ namespace dxvk {
           uint32_t                typeId,
           uint32_t                argCount,
     const uint32_t*               argIds) {
+    SpirvTypeConstKey key;
+    key.words.reserve(2 + argCount);
+    key.words.push_back(op);
+    key.words.push_back(typeId);
+    
+    for (uint32_t i = 0; i < argCount; i++)
+      key.words.push_back(argIds[i]);
+    
     // Avoid declaring constants multiple times
-    for (auto ins : m_typeConstDefs) {
-      bool match = ins.opCode() == op
-                && ins.length() == 3 + argCount
-                && ins.arg(1)   == typeId;
-      
-      for (uint32_t i = 0; i < argCount && match; i++)
-        match &= ins.arg(3 + i) == argIds[i];
-      
-      if (match)
-        return ins.arg(2);
-    }
+    auto entry = m_typeConstIds.find(key);
+    
+    if (entry != m_typeConstIds.end())
+      return entry->second;
     
     // Constant not yet declared, make a new one
     uint32_t resultId = this->allocateId();
@@ -3121,6 +3177,8 @@ namespace dxvk {
     
     for (uint32_t i = 0; i < argCount; i++)
       m_typeConstDefs.putWord(argIds[i]);
+    
+    m_typeConstIds.insert({ std::move(key), resultId });
     return resultId;
   }
   
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <unordered_map>
+
 #include "spirv_code_buffer.h"
 
 namespace dxvk {
@@ -27,6 +29,26 @@ namespace dxvk {
     uint32_t sMinLod       = 0;
   };
   
+  /**
+   * \brief Type or constant declaration key
+   * 
+   * Stores the opcode and all operands of a type or
+   * constant declaration except for the result ID,
+   * so that existing declarations can be looked up
+   * in constant time.
+   */
+  struct SpirvTypeConstKey {
+    std::vector<uint32_t> words;
+    
+    bool operator == (const SpirvTypeConstKey& other) const {
+      return words == other.words;
+    }
+  };
+  
+  struct SpirvTypeConstKeyHash {
+    size_t operator () (const SpirvTypeConstKey& key) const;
+  };
+  
   /**
    * \brief SPIR-V module
    * 
@@ -1008,6 +1030,15 @@ namespace dxvk {
             uint32_t                operation,
             uint32_t                ballot);
     
+    uint32_t opGroupNonUniformBroadcastFirst(
+            uint32_t                resultType,
+            uint32_t                execution,
+            uint32_t                value);
+    
+    uint32_t opGroupNonUniformElect(
+            uint32_t                resultType,
+            uint32_t                execution);
+    
     uint32_t opGroupNonUniformLogicalAnd(
             uint32_t                resultType,
             uint32_t                execution,
@@ -1079,6 +1110,11 @@ namespace dxvk {
     SpirvCodeBuffer m_variables;
     SpirvCodeBuffer m_code;
     
+    std::unordered_map<
+      SpirvTypeConstKey,
+      uint32_t,
+      SpirvTypeConstKeyHash> m_typeConstIds;
+    
     uint32_t defType(
             spv::Op                 op, 
             uint32_t                argCount,
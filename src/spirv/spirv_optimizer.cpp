@@ -0,0 +1,910 @@
+#include <array>
+#include <cstring>
+
+#include "spirv_optimizer.h"
+
+namespace dxvk {
+
+  SpirvOptimizer::SpirvOptimizer() {
+
+  }
+
+
+  SpirvOptimizer::~SpirvOptimizer() {
+
+  }
+
+
+  bool SpirvOptimizer::optimize(SpirvCodeBuffer& code) {
+    if (!parseModule(code))
+      return false;
+
+    forwardValues();
+
+    // Phi instructions may reference values which were
+    // replaced after the phi itself had been processed
+    for (uint32_t i = m_funcStart; i < m_funcEnd; i++)
+      forEachIdOperand(m_ins[i], [this] (uint32_t& id) { id = resolve(id); });
+
+    // Removing dead code may remove the last load
+    // from a variable, and vice versa, so run the
+    // passes twice to catch the common cases
+    for (uint32_t i = 0; i < 2; i++) {
+      removeDeadStores();
+      removeDeadCode();
+    }
+
+    code = buildModule();
+    return true;
+  }
+
+
+  bool SpirvOptimizer::parseModule(const SpirvCodeBuffer& code) {
+    const uint32_t* words = code.data();
+    const uint32_t  count = code.size() / sizeof(uint32_t);
+
+    if (count < 5 || words[0] != spv::MagicNumber)
+      return false;
+
+    m_code.assign(words, words + count);
+    m_bound = m_code[3];
+
+    m_defs   .assign(m_bound, ~0u);
+    m_replace.assign(m_bound, 0u);
+    m_pinned .assign(m_bound, false);
+
+    m_funcStart = ~0u;
+
+    uint32_t offset = 5;
+
+    while (offset < count) {
+      const uint32_t* w = &m_code[offset];
+
+      Ins ins;
+      ins.offset  = offset;
+      ins.length  = w[0] >> spv::WordCountShift;
+      ins.removed = false;
+
+      const spv::Op op = spv::Op(w[0] & spv::OpCodeMask);
+
+      if (ins.length == 0 || offset + ins.length > count)
+        return false;
+
+      if (op == spv::OpFunction && m_funcStart == ~0u)
+        m_funcStart = m_ins.size();
+
+      if (m_funcStart == ~0u) {
+        // Only track the global declarations that function
+        // code may refer to, and pin all IDs which have
+        // debug names or decorations assigned to them.
+        switch (op) {
+          case spv::OpName:
+          case spv::OpDecorate:
+            if (w[1] < m_bound)
+              m_pinned[w[1]] = true;
+            break;
+
+          case spv::OpExtInstImport:
+            ins.info.hasResult = true;
+
+            if (!std::strcmp(reinterpret_cast<const char*>(&w[2]), "GLSL.std.450"))
+              m_glslImport = w[1];
+            break;
+
+          case spv::OpConstant:
+          case spv::OpConstantComposite: {
+            SpirvTypeConstKey key;
+            key.words.push_back(op);
+            key.words.push_back(w[1]);
+
+            for (uint32_t i = 3; i < ins.length; i++)
+              key.words.push_back(w[i]);
+
+            m_consts.insert({ key, w[2] });
+          } /* fall through */
+
+          case spv::OpUndef:
+          case spv::OpVariable:
+          case spv::OpConstantTrue:
+          case spv::OpConstantFalse:
+          case spv::OpConstantNull:
+          case spv::OpSpecConstantTrue:
+          case spv::OpSpecConstantFalse:
+          case spv::OpSpecConstant:
+          case spv::OpSpecConstantComposite:
+          case spv::OpSpecConstantOp:
+            ins.info.hasType   = true;
+            ins.info.hasResult = true;
+            break;
+
+          default:
+            // Type declarations only have a result ID
+            if (op >= spv::OpTypeVoid && op <= spv::OpTypeForwardPointer)
+              ins.info.hasResult = true;
+        }
+      } else {
+        // Bail out if we don't know how to
+        // deal with a function instruction
+        if (!getOpInfo(op, ins.info))
+          return false;
+
+        // Extended instructions are pure unless they
+        // write to a pointer or come from an unknown set
+        if (op == spv::OpExtInst) {
+          ins.info.pure = w[3] == m_glslImport
+            && w[4] != spv::GLSLstd450Modf
+            && w[4] != spv::GLSLstd450Frexp;
+        }
+      }
+
+      if (ins.info.hasResult) {
+        const uint32_t id = w[ins.info.hasType ? 2 : 1];
+
+        if (id >= m_bound)
+          return false;
+
+        m_defs[id] = m_ins.size();
+      }
+
+      m_ins.push_back(ins);
+      offset += ins.length;
+    }
+
+    m_funcEnd = m_ins.size();
+    return m_funcStart != ~0u;
+  }
+
+
+  void SpirvOptimizer::forwardValues() {
+    // Known values of tracked variables within the current block
+    std::unordered_map<uint32_t, uint32_t> values;
+
+    auto invalidate = [this, &values] (uint32_t ptr) {
+      const uint32_t root = getPointerRoot(ptr);
+
+      if (root == ~0u)
+        values.clear();
+      else if (root != 0)
+        values.erase(root);
+    };
+
+    for (uint32_t i = m_funcStart; i < m_funcEnd; i++) {
+      forEachIdOperand(m_ins[i], [this] (uint32_t& id) { id = resolve(id); });
+
+      const uint32_t* w = &m_code[m_ins[i].offset];
+      const uint32_t  n = m_ins[i].length;
+
+      switch (spv::Op(w[0] & spv::OpCodeMask)) {
+        case spv::OpFunction:
+        case spv::OpLabel:
+        case spv::OpFunctionCall:
+          values.clear();
+          break;
+
+        case spv::OpLoad: {
+          const uint32_t ptr = w[3];
+
+          if (!isTrackedVariable(ptr) || n > 4)
+            break;
+
+          auto entry = values.find(ptr);
+
+          if (entry != values.end() && !m_pinned[w[2]]) {
+            replaceId(w[2], entry->second);
+            m_ins[i].removed = true;
+          } else {
+            values[ptr] = w[2];
+          }
+        } break;
+
+        case spv::OpStore: {
+          const uint32_t ptr = w[1];
+
+          if (!isTrackedVariable(ptr) || n > 3) {
+            invalidate(ptr);
+            break;
+          }
+
+          auto entry = values.find(ptr);
+
+          if (entry != values.end() && entry->second == w[2])
+            m_ins[i].removed = true;
+          else
+            values[ptr] = w[2];
+        } break;
+
+        case spv::OpExtInst:
+          // Only Modf and Frexp write to a pointer
+          if (w[3] != m_glslImport
+           || w[4] == spv::GLSLstd450Modf
+           || w[4] == spv::GLSLstd450Frexp)
+            values.clear();
+          break;
+
+        case spv::OpAtomicStore:
+          invalidate(w[1]);
+          break;
+
+        case spv::OpAtomicLoad:
+        case spv::OpAtomicExchange:
+        case spv::OpAtomicCompareExchange:
+        case spv::OpAtomicIIncrement:
+        case spv::OpAtomicIDecrement:
+        case spv::OpAtomicIAdd:
+        case spv::OpAtomicISub:
+        case spv::OpAtomicSMin:
+        case spv::OpAtomicUMin:
+        case spv::OpAtomicSMax:
+        case spv::OpAtomicUMax:
+        case spv::OpAtomicAnd:
+        case spv::OpAtomicOr:
+        case spv::OpAtomicXor:
+          invalidate(w[3]);
+          break;
+
+        default:
+          foldConstants(i);
+      }
+    }
+  }
+
+
+  void SpirvOptimizer::foldConstants(uint32_t insIdx) {
+    const Ins ins = m_ins[insIdx];
+    const uint32_t* w = &m_code[ins.offset];
+
+    if (!ins.info.hasType || !ins.info.hasResult || m_pinned[w[2]])
+      return;
+
+    const uint32_t typeId   = w[1];
+    const uint32_t resultId = w[2];
+
+    uint32_t value = 0;
+
+    switch (spv::Op(w[0] & spv::OpCodeMask)) {
+      case spv::OpCompositeExtract: {
+        value = w[3];
+
+        for (uint32_t i = 4; i < ins.length && value != 0; i++) {
+          const uint32_t* def = getDef(value);
+
+          if (def == nullptr || spv::Op(def[0] & spv::OpCodeMask) != spv::OpConstantComposite
+           || w[i] >= (def[0] >> spv::WordCountShift) - 3)
+            value = 0;
+          else
+            value = def[3 + w[i]];
+        }
+      } break;
+
+      case spv::OpVectorShuffle: {
+        const uint32_t a = w[3];
+        const uint32_t b = w[4];
+
+        const uint32_t aCount = getComponentCount(getTypeId(a));
+        const uint32_t bCount = getComponentCount(getTypeId(b));
+        const uint32_t count  = ins.length - 5;
+
+        if (aCount == 0 || bCount == 0 || count > 4)
+          break;
+
+        // Check whether the shuffle returns one of
+        // its operands without modifying it
+        bool aIdentity = getTypeId(a) == typeId && count == aCount;
+        bool bIdentity = getTypeId(b) == typeId && count == bCount;
+
+        for (uint32_t i = 0; i < count; i++) {
+          aIdentity &= w[5 + i] == i;
+          bIdentity &= w[5 + i] == i + aCount;
+        }
+
+        if (aIdentity || bIdentity) {
+          value = aIdentity ? a : b;
+          break;
+        }
+
+        const uint32_t* aDef = getDef(a);
+        const uint32_t* bDef = getDef(b);
+
+        if (spv::Op(aDef[0] & spv::OpCodeMask) != spv::OpConstantComposite
+         || spv::Op(bDef[0] & spv::OpCodeMask) != spv::OpConstantComposite)
+          break;
+
+        std::array<uint32_t, 4> args;
+
+        for (uint32_t i = 0; i < count; i++) {
+          const uint32_t index = w[5 + i];
+
+          if (index >= aCount + bCount)
+            return;
+
+          args[i] = index < aCount
+            ? aDef[3 + index]
+            : bDef[3 + index - aCount];
+        }
+
+        value = getConst(spv::OpConstantComposite, typeId, count, args.data());
+      } break;
+
+      case spv::OpCompositeConstruct: {
+        const uint32_t count = ins.length - 3;
+
+        if (getComponentCount(typeId) != count || count > 4)
+          break;
+
+        std::array<uint32_t, 4> args;
+
+        for (uint32_t i = 0; i < count; i++) {
+          const uint32_t* def = getDef(w[3 + i]);
+
+          if (def == nullptr)
+            return;
+
+          switch (spv::Op(def[0] & spv::OpCodeMask)) {
+            case spv::OpConstant:
+            case spv::OpConstantTrue:
+            case spv::OpConstantFalse:
+            case spv::OpConstantNull:
+              args[i] = w[3 + i];
+              break;
+
+            default:
+              return;
+          }
+        }
+
+        value = getConst(spv::OpConstantComposite, typeId, count, args.data());
+      } break;
+
+      case spv::OpBitcast:
+        value = foldBitcast(typeId, w[3]);
+        break;
+
+      default:
+        break;
+    }
+
+    if (value != 0) {
+      replaceId(resultId, value);
+      m_ins[insIdx].removed = true;
+    }
+  }
+
+
+  void SpirvOptimizer::removeDeadStores() {
+    std::vector<bool> read(m_bound, false);
+
+    for (uint32_t i = m_funcStart; i < m_funcEnd; i++) {
+      const Ins& ins = m_ins[i];
+
+      if (ins.removed)
+        continue;
+
+      // Storing to a variable does not count as a read,
+      // but any other use of the pointer does
+      const bool isStore = spv::Op(m_code[ins.offset] & spv::OpCodeMask) == spv::OpStore;
+      const uint32_t* ptr = isStore ? &m_code[ins.offset + 1] : nullptr;
+
+      forEachIdOperand(ins, [&read, ptr] (uint32_t& id) {
+        if (&id != ptr)
+          read[id] = true;
+      });
+    }
+
+    for (uint32_t i = m_funcStart; i < m_funcEnd; i++) {
+      const uint32_t* w = &m_code[m_ins[i].offset];
+
+      if (!m_ins[i].removed
+       && spv::Op(w[0] & spv::OpCodeMask) == spv::OpStore
+       && isTrackedVariable(w[1]) && !read[w[1]])
+        m_ins[i].removed = true;
+    }
+  }
+
+
+  void SpirvOptimizer::removeDeadCode() {
+    std::vector<uint32_t> uses(m_bound, 0);
+    std::vector<uint32_t> worklist;
+
+    for (uint32_t i = m_funcStart; i < m_funcEnd; i++) {
+      if (!m_ins[i].removed)
+        forEachIdOperand(m_ins[i], [&uses] (uint32_t& id) { uses[id] += 1; });
+    }
+
+    auto isDead = [this, &uses] (uint32_t insIdx) {
+      const Ins& ins = m_ins[insIdx];
+
+      if (insIdx < m_funcStart || insIdx >= m_funcEnd
+       || ins.removed || !ins.info.pure || !ins.info.hasResult)
+        return false;
+
+      const uint32_t id = m_code[ins.offset + (ins.info.hasType ? 2 : 1)];
+      return uses[id] == 0 && !m_pinned[id];
+    };
+
+    for (uint32_t i = m_funcStart; i < m_funcEnd; i++) {
+      if (isDead(i))
+        worklist.push_back(i);
+    }
+
+    while (!worklist.empty()) {
+      const uint32_t insIdx = worklist.back();
+      worklist.pop_back();
+
+      if (m_ins[insIdx].removed)
+        continue;
+
+      m_ins[insIdx].removed = true;
+
+      forEachIdOperand(m_ins[insIdx], [this, &uses, &worklist, &isDead] (uint32_t& id) {
+        uses[id] -= 1;
+
+        if (uses[id] == 0 && m_defs[id] != ~0u && isDead(m_defs[id]))
+          worklist.push_back(m_defs[id]);
+      });
+    }
+  }
+
+
+  SpirvCodeBuffer SpirvOptimizer::buildModule() const {
+    SpirvCodeBuffer result;
+    result.reserve(m_code.size());
+
+    for (uint32_t i = 0; i < 5; i++)
+      result.putWord(i == 3 ? m_bound : m_code[i]);
+
+    auto putIns = [this, &result] (const Ins& ins) {
+      for (uint32_t i = 0; i < ins.length; i++)
+        result.putWord(m_code[ins.offset + i]);
+    };
+
+    for (uint32_t i = 0; i < m_funcStart; i++)
+      putIns(m_ins[i]);
+
+    // Constants created by the optimizer only depend
+    // on global declarations, so we can insert them
+    // right before the first function
+    for (uint32_t insIdx : m_newConsts)
+      putIns(m_ins[insIdx]);
+
+    for (uint32_t i = m_funcStart; i < m_funcEnd; i++) {
+      if (!m_ins[i].removed)
+        putIns(m_ins[i]);
+    }
+
+    return result;
+  }
+
+
+  template<typename Fn>
+  void SpirvOptimizer::forEachIdOperand(const Ins& ins, Fn fn) {
+    uint32_t* w = &m_code[ins.offset];
+
+    const uint32_t first = 1
+      + (ins.info.hasType   ? 1 : 0)
+      + (ins.info.hasResult ? 1 : 0);
+
+    const uint32_t last = std::min(ins.length, first + ins.info.idCount);
+
+    switch (ins.info.layout) {
+      case OperandLayout::Ids:
+        for (uint32_t i = first; i < ins.length; i++)
+          fn(w[i]);
+        break;
+
+      case OperandLayout::IdsLiterals:
+        for (uint32_t i = first; i < last; i++)
+          fn(w[i]);
+        break;
+
+      case OperandLayout::IdsLiteralIds:
+        for (uint32_t i = first; i < last; i++)
+          fn(w[i]);
+        for (uint32_t i = last + 1; i < ins.length; i++)
+          fn(w[i]);
+        break;
+
+      case OperandLayout::Switch:
+        // The selector is always a 32-bit integer
+        for (uint32_t i = first; i < last; i++)
+          fn(w[i]);
+        for (uint32_t i = first + 3; i < ins.length; i += 2)
+          fn(w[i]);
+        break;
+    }
+  }
+
+
+  const uint32_t* SpirvOptimizer::getDef(uint32_t id) const {
+    if (id >= m_bound || m_defs[id] == ~0u)
+      return nullptr;
+
+    return &m_code[m_ins[m_defs[id]].offset];
+  }
+
+
+  uint32_t SpirvOptimizer::getTypeId(uint32_t id) const {
+    const uint32_t* def = getDef(id);
+
+    return def != nullptr && m_ins[m_defs[id]].info.hasType
+      ? def[1] : 0;
+  }
+
+
+  uint32_t SpirvOptimizer::getComponentCount(uint32_t typeId) const {
+    const uint32_t* def = getDef(typeId);
+
+    return def != nullptr && spv::Op(def[0] & spv::OpCodeMask) == spv::OpTypeVector
+      ? def[3] : 0;
+  }
+
+
+  uint32_t SpirvOptimizer::getPointerRoot(uint32_t id) const {
+    while (true) {
+      const uint32_t* def = getDef(id);
+
+      if (def == nullptr)
+        return ~0u;
+
+      switch (spv::Op(def[0] & spv::OpCodeMask)) {
+        case spv::OpAccessChain:
+        case spv::OpInBoundsAccessChain:
+          id = def[3];
+          break;
+
+        case spv::OpVariable:
+          return id;
+
+        // Image pointers cannot alias variables
+        case spv::OpImageTexelPointer:
+          return 0;
+
+        default:
+          return ~0u;
+      }
+    }
+  }
+
+
+  bool SpirvOptimizer::isTrackedVariable(uint32_t id) const {
+    const uint32_t* def = getDef(id);
+
+    return def != nullptr
+        && spv::Op(def[0] & spv::OpCodeMask) == spv::OpVariable
+        && (def[3] == spv::StorageClassPrivate
+         || def[3] == spv::StorageClassFunction);
+  }
+
+
+  uint32_t SpirvOptimizer::resolve(uint32_t id) const {
+    while (id < m_bound && m_replace[id] != 0)
+      id = m_replace[id];
+
+    return id;
+  }
+
+
+  void SpirvOptimizer::replaceId(uint32_t id, uint32_t value) {
+    if (id != value)
+      m_replace[id] = value;
+  }
+
+
+  uint32_t SpirvOptimizer::getConst(
+          spv::Op           op,
+          uint32_t          typeId,
+          uint32_t          argCount,
+    const uint32_t*         args) {
+    SpirvTypeConstKey key;
+    key.words.push_back(op);
+    key.words.push_back(typeId);
+
+    for (uint32_t i = 0; i < argCount; i++)
+      key.words.push_back(args[i]);
+
+    auto entry = m_consts.find(key);
+
+    if (entry != m_consts.end())
+      return entry->second;
+
+    const uint32_t id = m_bound++;
+
+    Ins ins;
+    ins.offset         = m_code.size();
+    ins.length         = argCount + 3;
+    ins.info.hasType   = true;
+    ins.info.hasResult = true;
+    ins.removed        = false;
+
+    m_code.push_back(op | (ins.length << spv::WordCountShift));
+    m_code.push_back(typeId);
+    m_code.push_back(id);
+
+    for (uint32_t i = 2; i < key.words.size(); i++)
+      m_code.push_back(key.words[i]);
+
+    m_defs   .push_back(m_ins.size());
+    m_replace.push_back(0u);
+    m_pinned .push_back(false);
+
+    m_newConsts.push_back(m_ins.size());
+    m_ins.push_back(ins);
+
+    m_consts.insert({ key, id });
+    return id;
+  }
+
+
+  uint32_t SpirvOptimizer::foldBitcast(
+          uint32_t          typeId,
+          uint32_t          valueId) {
+    const uint32_t* typeDef  = getDef(typeId);
+    const uint32_t* valueDef = getDef(valueId);
+
+    if (typeDef == nullptr || valueDef == nullptr)
+      return 0;
+
+    const spv::Op valueOp = spv::Op(valueDef[0] & spv::OpCodeMask);
+    const uint32_t valueLength = valueDef[0] >> spv::WordCountShift;
+
+    switch (spv::Op(typeDef[0] & spv::OpCodeMask)) {
+      case spv::OpTypeInt:
+      case spv::OpTypeFloat: {
+        if (typeDef[2] != 32 || valueOp != spv::OpConstant || valueLength != 4)
+          return 0;
+
+        const uint32_t word = valueDef[3];
+        return getConst(spv::OpConstant, typeId, 1, &word);
+      }
+
+      case spv::OpTypeVector: {
+        const uint32_t count = typeDef[3];
+        const uint32_t componentTypeId = typeDef[2];
+
+        if (valueOp != spv::OpConstantComposite || valueLength != count + 3 || count > 4)
+          return 0;
+
+        // Creating constants may invalidate the
+        // definition pointer, so copy the IDs
+        std::array<uint32_t, 4> args;
+
+        for (uint32_t i = 0; i < count; i++)
+          args[i] = valueDef[3 + i];
+
+        for (uint32_t i = 0; i < count; i++) {
+          if (!(args[i] = foldBitcast(componentTypeId, args[i])))
+            return 0;
+        }
+
+        return getConst(spv::OpConstantComposite, typeId, count, args.data());
+      }
+
+      default:
+        return 0;
+    }
+  }
+
+
+  bool SpirvOptimizer::getOpInfo(spv::Op op, OpInfo& info) {
+    switch (op) {
+      // Pure instructions with a result type, only taking IDs
+      case spv::OpFNegate:
+      case spv::OpFAdd:
+      case spv::OpFSub:
+      case spv::OpFMul:
+      case spv::OpFDiv:
+      case spv::OpSNegate:
+      case spv::OpIAdd:
+      case spv::OpISub:
+      case spv::OpIMul:
+      case spv::OpSDiv:
+      case spv::OpUDiv:
+      case spv::OpSRem:
+      case spv::OpUMod:
+      case spv::OpDot:
+      case spv::OpBitCount:
+      case spv::OpBitFieldInsert:
+      case spv::OpBitFieldSExtract:
+      case spv::OpBitFieldUExtract:
+      case spv::OpBitReverse:
+      case spv::OpBitwiseAnd:
+      case spv::OpBitwiseOr:
+      case spv::OpBitwiseXor:
+      case spv::OpNot:
+      case spv::OpShiftLeftLogical:
+      case spv::OpShiftRightArithmetic:
+      case spv::OpShiftRightLogical:
+      case spv::OpBitcast:
+      case spv::OpConvertFToS:
+      case spv::OpConvertFToU:
+      case spv::OpConvertSToF:
+      case spv::OpConvertUToF:
+      case spv::OpFConvert:
+      case spv::OpFOrdEqual:
+      case spv::OpFOrdNotEqual:
+      case spv::OpFOrdLessThan:
+      case spv::OpFOrdLessThanEqual:
+      case spv::OpFOrdGreaterThan:
+      case spv::OpFOrdGreaterThanEqual:
+      case spv::OpIEqual:
+      case spv::OpINotEqual:
+      case spv::OpSLessThan:
+      case spv::OpSLessThanEqual:
+      case spv::OpSGreaterThan:
+      case spv::OpSGreaterThanEqual:
+      case spv::OpULessThan:
+      case spv::OpULessThanEqual:
+      case spv::OpUGreaterThan:
+      case spv::OpUGreaterThanEqual:
+      case spv::OpLogicalAnd:
+      case spv::OpLogicalOr:
+      case spv::OpLogicalNot:
+      case spv::OpLogicalEqual:
+      case spv::OpLogicalNotEqual:
+      case spv::OpAll:
+      case spv::OpAny:
+      case spv::OpSelect:
+      case spv::OpCompositeConstruct:
+      case spv::OpVectorExtractDynamic:
+      case spv::OpCopyObject:
+      case spv::OpAccessChain:
+      case spv::OpInBoundsAccessChain:
+      case spv::OpImageTexelPointer:
+      case spv::OpSampledImage:
+      case spv::OpImage:
+      case spv::OpImageQuerySize:
+      case spv::OpImageQuerySizeLod:
+      case spv::OpImageQueryLevels:
+      case spv::OpImageQueryLod:
+      case spv::OpImageQuerySamples:
+      case spv::OpDPdx:
+      case spv::OpDPdy:
+      case spv::OpDPdxFine:
+      case spv::OpDPdyFine:
+      case spv::OpDPdxCoarse:
+      case spv::OpDPdyCoarse:
+      case spv::OpGroupNonUniformBallot:
+      case spv::OpGroupNonUniformBroadcastFirst:
+      case spv::OpGroupNonUniformElect:
+      case spv::OpPhi:
+        info.hasType = true;
+        info.hasResult = true;
+        info.pure = true;
+        return true;
+
+      // Pure instructions with trailing literals
+      case spv::OpLoad:
+      case spv::OpCompositeExtract:
+      case spv::OpArrayLength:
+        info.hasType = true;
+        info.hasResult = true;
+        info.pure = true;
+        info.layout = OperandLayout::IdsLiterals;
+        info.idCount = 1;
+        return true;
+
+      case spv::OpCompositeInsert:
+      case spv::OpVectorShuffle:
+        info.hasType = true;
+        info.hasResult = true;
+        info.pure = true;
+        info.layout = OperandLayout::IdsLiterals;
+        info.idCount = 2;
+        return true;
+
+      // Pure instructions with an embedded literal
+      case spv::OpExtInst:
+      case spv::OpGroupNonUniformBallotBitCount:
+      case spv::OpGroupNonUniformLogicalAnd:
+        info.hasType = true;
+        info.hasResult = true;
+        info.pure = true;
+        info.layout = OperandLayout::IdsLiteralIds;
+        info.idCount = 1;
+        return true;
+
+      // Image instructions with optional image operands
+      case spv::OpImageSampleImplicitLod:
+      case spv::OpImageSampleExplicitLod:
+      case spv::OpImageFetch:
+      case spv::OpImageRead:
+        info.hasType = true;
+        info.hasResult = true;
+        info.pure = true;
+        info.layout = OperandLayout::IdsLiteralIds;
+        info.idCount = 2;
+        return true;
+
+      case spv::OpImageSampleDrefImplicitLod:
+      case spv::OpImageSampleDrefExplicitLod:
+      case spv::OpImageGather:
+      case spv::OpImageDrefGather:
+        info.hasType = true;
+        info.hasResult = true;
+        info.pure = true;
+        info.layout = OperandLayout::IdsLiteralIds;
+        info.idCount = 3;
+        return true;
+
+      case spv::OpImageWrite:
+        info.layout = OperandLayout::IdsLiteralIds;
+        info.idCount = 3;
+        return true;
+
+      // Instructions with side effects
+      case spv::OpFunctionCall:
+      case spv::OpFunctionParameter:
+      case spv::OpAtomicLoad:
+      case spv::OpAtomicExchange:
+      case spv::OpAtomicCompareExchange:
+      case spv::OpAtomicIIncrement:
+      case spv::OpAtomicIDecrement:
+      case spv::OpAtomicIAdd:
+      case spv::OpAtomicISub:
+      case spv::OpAtomicSMin:
+      case spv::OpAtomicUMin:
+      case spv::OpAtomicSMax:
+      case spv::OpAtomicUMax:
+      case spv::OpAtomicAnd:
+      case spv::OpAtomicOr:
+      case spv::OpAtomicXor:
+        info.hasType = true;
+        info.hasResult = true;
+        return true;
+
+      case spv::OpFunction:
+      case spv::OpVariable:
+        info.hasType = true;
+        info.hasResult = true;
+        info.layout = OperandLayout::IdsLiteralIds;
+        info.idCount = 0;
+        return true;
+
+      case spv::OpLabel:
+        info.hasResult = true;
+        return true;
+
+      case spv::OpStore:
+        info.layout = OperandLayout::IdsLiterals;
+        info.idCount = 2;
+        return true;
+
+      case spv::OpSelectionMerge:
+        info.layout = OperandLayout::IdsLiterals;
+        info.idCount = 1;
+        return true;
+
+      case spv::OpLoopMerge:
+        info.layout = OperandLayout::IdsLiterals;
+        info.idCount = 2;
+        return true;
+
+      case spv::OpBranchConditional:
+        info.layout = OperandLayout::IdsLiterals;
+        info.idCount = 3;
+        return true;
+
+      case spv::OpSwitch:
+        info.layout = OperandLayout::Switch;
+        info.idCount = 2;
+        return true;
+
+      case spv::OpAtomicStore:
+      case spv::OpControlBarrier:
+      case spv::OpMemoryBarrier:
+      case spv::OpBranch:
+      case spv::OpReturn:
+      case spv::OpReturnValue:
+      case spv::OpKill:
+      case spv::OpEmitVertex:
+      case spv::OpEndPrimitive:
+      case spv::OpEmitStreamVertex:
+      case spv::OpEndStreamPrimitive:
+      case spv::OpFunctionEnd:
+        return true;
+
+      default:
+        return false;
+    }
+  }
+
+}
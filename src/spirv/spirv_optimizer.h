@@ -0,0 +1,133 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "spirv_code_buffer.h"
+#include "spirv_module.h"
+
+namespace dxvk {
+
+  /**
+   * \brief SPIR-V optimizer
+   *
+   * Runs a set of simple passes on a compiled SPIR-V
+   * module in order to reduce its size before it gets
+   * passed to the driver:
+   *
+   * - Loads from \c Private and \c Function variables
+   *   are replaced by the last value stored to or loaded
+   *   from the same variable within the same block, and
+   *   stores of a variable's known value are removed.
+   * - Stores to variables which are never read are removed.
+   * - Composite extracts, vector shuffles, composite
+   *   constructs and bitcasts of constants are folded,
+   *   and identity shuffles are removed.
+   * - Instructions without side effects whose results
+   *   are not used are removed.
+   *
+   * Modules containing instructions that the optimizer
+   * does not know about are left unchanged.
+   */
+  class SpirvOptimizer {
+
+  public:
+
+    SpirvOptimizer();
+    ~SpirvOptimizer();
+
+    /**
+     * \brief Optimizes a SPIR-V module
+     *
+     * \param [in,out] code The module to optimize
+     * \returns \c true if the module was optimized,
+     *    \c false if it was left unchanged
+     */
+    bool optimize(SpirvCodeBuffer& code);
+
+  private:
+
+    enum class OperandLayout : uint32_t {
+      Ids,            ///< All operands are IDs
+      IdsLiterals,    ///< Fixed number of IDs, followed by literals
+      IdsLiteralIds,  ///< Fixed number of IDs, one literal, then IDs
+      Switch,         ///< Selector, default label and literal-label pairs
+    };
+
+    struct OpInfo {
+      bool          hasType   = false;
+      bool          hasResult = false;
+      bool          pure      = false;
+      OperandLayout layout    = OperandLayout::Ids;
+      uint32_t      idCount   = 0;
+    };
+
+    struct Ins {
+      uint32_t      offset;
+      uint32_t      length;
+      OpInfo        info;
+      bool          removed;
+    };
+
+    std::vector<uint32_t> m_code;
+    std::vector<Ins>      m_ins;
+    std::vector<uint32_t> m_newConsts;
+
+    uint32_t m_bound      = 0;
+    uint32_t m_funcStart  = 0;
+    uint32_t m_funcEnd    = 0;
+    uint32_t m_glslImport = 0;
+
+    std::vector<uint32_t> m_defs;
+    std::vector<uint32_t> m_replace;
+    std::vector<bool>     m_pinned;
+
+    std::unordered_map<
+      SpirvTypeConstKey,
+      uint32_t,
+      SpirvTypeConstKeyHash> m_consts;
+
+    bool parseModule(const SpirvCodeBuffer& code);
+
+    void forwardValues();
+
+    void foldConstants(uint32_t insIdx);
+
+    void removeDeadStores();
+
+    void removeDeadCode();
+
+    SpirvCodeBuffer buildModule() const;
+
+    template<typename Fn>
+    void forEachIdOperand(const Ins& ins, Fn fn);
+
+    const uint32_t* getDef(uint32_t id) const;
+
+    uint32_t getTypeId(uint32_t id) const;
+
+    uint32_t getComponentCount(uint32_t typeId) const;
+
+    uint32_t getPointerRoot(uint32_t id) const;
+
+    bool isTrackedVariable(uint32_t id) const;
+
+    uint32_t resolve(uint32_t id) const;
+
+    void replaceId(uint32_t id, uint32_t value);
+
+    uint32_t getConst(
+            spv::Op           op,
+            uint32_t          typeId,
+            uint32_t          argCount,
+      const uint32_t*         args);
+
+    uint32_t foldBitcast(
+            uint32_t          typeId,
+            uint32_t          valueId);
+
+    static bool getOpInfo(spv::Op op, OpInfo& info);
+
+  };
+
+}
@@ -0,0 +1,249 @@
+#include <unordered_set>
+
+#include "spirv_output_pruner.h"
+
+namespace dxvk {
+
+  SpirvOutputPruner::SpirvOutputPruner() {
+
+  }
+
+
+  SpirvOutputPruner::~SpirvOutputPruner() {
+
+  }
+
+
+  bool SpirvOutputPruner::prune(
+          SpirvCodeBuffer&  code,
+          uint32_t          locationMask) {
+    const uint32_t* words = code.data();
+    const uint32_t  count = code.size() / sizeof(uint32_t);
+
+    if (count < 5 || words[0] != spv::MagicNumber)
+      return false;
+
+    m_code.assign(words, words + count);
+    m_roots.clear();
+
+    std::unordered_map<uint32_t, uint32_t> locations;
+    std::unordered_map<uint32_t, uint32_t> resultTypes;
+
+    std::vector<uint32_t> outputs;
+    std::vector<std::pair<uint32_t, uint32_t>> chains;
+
+    // Find output variables and their locations, as
+    // well as all access chains that may use them
+    for (uint32_t offset = 5; offset < count; ) {
+      const uint32_t* args = &m_code[offset];
+      const uint32_t  len  = args[0] >> spv::WordCountShift;
+
+      if (!len || offset + len > count)
+        return false;
+
+      switch (args[0] & spv::OpCodeMask) {
+        case spv::OpCapability:
+          if (args[1] == spv::CapabilityTransformFeedback)
+            return false;
+          break;
+
+        case spv::OpDecorate:
+          if (len >= 4 && args[2] == spv::DecorationLocation)
+            locations.insert({ args[1], args[3] });
+          break;
+
+        case spv::OpVariable:
+          if (args[3] == spv::StorageClassOutput) {
+            outputs.push_back(args[2]);
+            resultTypes.insert({ args[2], args[1] });
+          } break;
+
+        case spv::OpAccessChain:
+        case spv::OpInBoundsAccessChain:
+          chains.push_back({ args[2], args[3] });
+          resultTypes.insert({ args[2], args[1] });
+          break;
+
+        default:
+          break;
+      }
+
+      offset += len;
+    }
+
+    for (uint32_t varId : outputs) {
+      auto location = locations.find(varId);
+
+      if (location != locations.end() && location->second < 32
+       && !(locationMask & (1u << location->second)))
+        m_roots.insert({ varId, varId });
+    }
+
+    if (m_roots.empty())
+      return false;
+
+    // Access chains can be based on other access chains,
+    // which are not necessarily defined in order
+    for (bool progress = true; progress; ) {
+      progress = false;
+
+      for (const auto& chain : chains) {
+        uint32_t root = getRoot(chain.second);
+
+        if (root && m_roots.insert({ chain.first, root }).second)
+          progress = true;
+      }
+    }
+
+    // Check that the variables are only used by instructions
+    // that remain valid if the storage class changes. This
+    // may have false positives, which is harmless.
+    std::unordered_set<uint32_t> unsafe;
+
+    for (uint32_t offset = 5; offset < count; ) {
+      const uint32_t* args = &m_code[offset];
+      const uint32_t  len  = args[0] >> spv::WordCountShift;
+
+      uint32_t first = 1;
+      uint32_t skip  = 0;
+
+      switch (args[0] & spv::OpCodeMask) {
+        case spv::OpName:
+        case spv::OpDecorate:
+        case spv::OpEntryPoint:
+        case spv::OpVariable:
+          first = len;
+          break;
+
+        case spv::OpAccessChain:
+        case spv::OpInBoundsAccessChain:
+          first = 4;
+          break;
+
+        case spv::OpLoad:
+          skip = 3;
+          break;
+
+        case spv::OpStore:
+          skip = 1;
+          break;
+
+        default:
+          break;
+      }
+
+      for (uint32_t i = first; i < len; i++) {
+        uint32_t root = i != skip ? getRoot(args[i]) : 0;
+
+        if (root)
+          unsafe.insert(root);
+      }
+
+      offset += len;
+    }
+
+    for (auto i = m_roots.begin(); i != m_roots.end(); ) {
+      if (unsafe.find(i->second) != unsafe.end())
+        i = m_roots.erase(i);
+      else
+        i++;
+    }
+
+    if (m_roots.empty())
+      return false;
+
+    // Declare private pointer types for all output pointer
+    // types that are used. Duplicate pointer types are legal,
+    // so we do not need to look for existing ones.
+    uint32_t bound = m_code[3];
+
+    std::unordered_map<uint32_t, uint32_t> privateTypes;
+
+    for (const auto& r : m_roots) {
+      uint32_t typeId = resultTypes.at(r.first);
+
+      if (privateTypes.find(typeId) == privateTypes.end())
+        privateTypes.insert({ typeId, bound++ });
+    }
+
+    std::vector<uint32_t> result;
+    result.reserve(count + 4 * privateTypes.size());
+    result.insert(result.end(), m_code.begin(), m_code.begin() + 5);
+    result[3] = bound;
+
+    for (uint32_t offset = 5; offset < count; ) {
+      const uint32_t* args = &m_code[offset];
+      const uint32_t  len  = args[0] >> spv::WordCountShift;
+      const uint32_t  op   = args[0] & spv::OpCodeMask;
+
+      offset += len;
+
+      if (op == spv::OpEntryPoint) {
+        // The interface list follows the name
+        // string, whose last word ends with a
+        // null byte
+        uint32_t start = result.size();
+        uint32_t iface = 3;
+
+        while (iface < len && (args[iface] >> 24))
+          iface += 1;
+
+        for (uint32_t i = 0; i < len; i++) {
+          if (i <= iface || m_roots.find(args[i]) == m_roots.end())
+            result.push_back(args[i]);
+        }
+
+        uint32_t newLen = result.size() - start;
+        result[start] = op | (newLen << spv::WordCountShift);
+        continue;
+      }
+
+      if (op == spv::OpDecorate && m_roots.find(args[1]) != m_roots.end())
+        continue;
+
+      uint32_t start = result.size();
+      result.insert(result.end(), args, args + len);
+
+      switch (op) {
+        case spv::OpTypePointer: {
+          auto type = privateTypes.find(args[1]);
+
+          if (type != privateTypes.end()) {
+            result.push_back(spv::OpTypePointer | (4 << spv::WordCountShift));
+            result.push_back(type->second);
+            result.push_back(spv::StorageClassPrivate);
+            result.push_back(args[3]);
+          }
+        } break;
+
+        case spv::OpVariable:
+          if (m_roots.find(args[2]) != m_roots.end()) {
+            result[start + 1] = privateTypes.at(args[1]);
+            result[start + 3] = spv::StorageClassPrivate;
+          } break;
+
+        case spv::OpAccessChain:
+        case spv::OpInBoundsAccessChain:
+          if (m_roots.find(args[2]) != m_roots.end())
+            result[start + 1] = privateTypes.at(args[1]);
+          break;
+
+        default:
+          break;
+      }
+    }
+
+    code = SpirvCodeBuffer(result.size(), result.data());
+    return true;
+  }
+
+
+  uint32_t SpirvOutputPruner::getRoot(uint32_t id) const {
+    auto entry = m_roots.find(id);
+
+    return entry != m_roots.end()
+      ? entry->second
+      : 0;
+  }
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "spirv_code_buffer.h"
+
+namespace dxvk {
+
+  /**
+   * \brief SPIR-V output pruner
+   *
+   * Demotes output variables whose locations are not
+   * consumed by the next shader stage to \c Private
+   * variables, and removes them from the entry point
+   * interface. This does not remove any computations
+   * by itself, but running the optimizer afterwards
+   * removes the stores to these variables as well as
+   * any code that only contributes to them.
+   *
+   * Variables that are used by instructions other
+   * than loads, stores and access chains are left
+   * unchanged, as are modules using transform
+   * feedback, since captured outputs must be kept.
+   */
+  class SpirvOutputPruner {
+
+  public:
+
+    SpirvOutputPruner();
+    ~SpirvOutputPruner();
+
+    /**
+     * \brief Removes unused outputs
+     *
+     * \param [in,out] code The module to process
+     * \param [in] locationMask Output locations
+     *    that are consumed by the next stage
+     * \returns \c true if any outputs were removed
+     */
+    bool prune(
+            SpirvCodeBuffer&  code,
+            uint32_t          locationMask);
+
+  private:
+
+    std::vector<uint32_t> m_code;
+
+    std::unordered_map<uint32_t, uint32_t> m_roots;
+
+    uint32_t getRoot(uint32_t id) const;
+
+  };
+
+}
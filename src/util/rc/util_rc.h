@@ -27,6 +27,25 @@ namespace dxvk {
       return --m_refCount;
     }
     
+    /**
+     * \brief Increments reference count if non-zero
+     * 
+     * Allows acquiring a reference to an object that
+     * is not owned by the caller and may be in the
+     * process of being destroyed.
+     * \returns \c true if a reference was acquired
+     */
+    bool tryIncRef() {
+      uint32_t count = m_refCount.load();
+      
+      do {
+        if (!count)
+          return false;
+      } while (!m_refCount.compare_exchange_weak(count, count + 1));
+      
+      return true;
+    }
+    
   private:
     
     std::atomic<uint32_t> m_refCount = { 0u };
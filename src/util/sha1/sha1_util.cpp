@@ -37,6 +37,10 @@ namespace dxvk {
     SHA1Init(&ctx);
     
     for (size_t i = 0; i < numChunks; i++) {
+      // Empty chunks may not have a valid data pointer
+      if (chunks[i].size == 0)
+        continue;
+      
       auto ptr = reinterpret_cast<const uint8_t*>(chunks[i].data);
       SHA1Update(&ctx, ptr, chunks[i].size);
     }
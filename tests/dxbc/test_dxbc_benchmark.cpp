@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+
+#include <dirent.h>
+
+#include "../../src/dxbc/dxbc_module.h"
+#include "../../src/dxvk/dxvk_shader.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("dxbc-benchmark.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Named set of compiler options
+ */
+struct BenchmarkConfig {
+  const char* name;
+  DxbcOptions options;
+};
+
+
+/**
+ * \brief Compilation result for one shader
+ */
+struct BenchmarkResult {
+  bool     success      = false;
+  uint64_t timeUs       = 0;
+  uint64_t codeSize     = 0;
+  uint64_t insCount     = 0;
+};
+
+
+/**
+ * \brief Results, indexed by file and config name
+ */
+using BenchmarkResults = std::map<std::pair<std::string, std::string>, BenchmarkResult>;
+
+
+/**
+ * \brief Builds option sets to benchmark
+ *
+ * Covers the default options, the options used on
+ * devices which support all relevant features, and
+ * the SPIR-V optimizer on top of that. The overhead
+ * of shader-side buffer bounds checks is measured
+ * relative to the \c features configuration.
+ * \returns Compiler option sets
+ */
+std::vector<BenchmarkConfig> getConfigs() {
+  std::vector<BenchmarkConfig> result;
+
+  BenchmarkConfig config;
+  config.name = "default";
+  result.push_back(config);
+
+  config.name = "features";
+  config.options.useStorageImageReadWithoutFormat = true;
+  config.options.useSubgroupOpsForEarlyDiscard    = true;
+  config.options.useSubgroupOpsForAtomicCounters  = true;
+  config.options.useRawSsbo                       = true;
+  config.options.usePushConstants                 = true;
+  config.options.parallelizeHsForkPhases          = true;
+  result.push_back(config);
+
+  BenchmarkConfig bounds = config;
+  bounds.name = "bounds";
+  bounds.options.useBufferBoundsChecks = true;
+
+  config.name = "optimized";
+  config.options.optimizeSpirv = true;
+  result.push_back(config);
+
+  result.push_back(bounds);
+  return result;
+}
+
+
+/**
+ * \brief Lists DXBC files in a directory
+ *
+ * \param [in] path Directory path
+ * \returns Sorted list of file names
+ */
+std::vector<std::string> listShaders(const std::string& path) {
+  std::vector<std::string> result;
+
+  DIR* dir = opendir(path.c_str());
+
+  if (dir == nullptr)
+    return result;
+
+  while (dirent* entry = readdir(dir)) {
+    std::string name = entry->d_name;
+
+    if (name.size() > 5 && name.substr(name.size() - 5) == ".dxbc")
+      result.push_back(name);
+  }
+
+  closedir(dir);
+
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+
+/**
+ * \brief Compiles a shader
+ *
+ * Measures the fastest out of a number of runs in
+ * order to reduce noise, and counts the number of
+ * SPIR-V instructions in the generated code.
+ * \param [in] dxbcCode DXBC shader binary
+ * \param [in] name Shader name
+ * \param [in] config Compiler options
+ * \param [in] iterations Number of runs
+ * \returns Compilation result
+ */
+BenchmarkResult compileShader(
+  const std::vector<char>&  dxbcCode,
+  const std::string&        name,
+  const BenchmarkConfig&    config,
+        uint32_t            iterations) {
+  BenchmarkResult result;
+
+  DxbcModuleInfo moduleInfo;
+  moduleInfo.options = config.options;
+  moduleInfo.tess    = nullptr;
+  moduleInfo.xfb     = nullptr;
+
+  try {
+    Rc<DxvkShader> shader;
+
+    for (uint32_t i = 0; i < iterations; i++) {
+      auto t0 = std::chrono::high_resolution_clock::now();
+
+      DxbcReader reader(dxbcCode.data(), dxbcCode.size());
+      DxbcModule module(reader);
+      shader = module.compile(moduleInfo, name);
+
+      auto t1 = std::chrono::high_resolution_clock::now();
+      uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+
+      if (i == 0 || us < result.timeUs)
+        result.timeUs = us;
+    }
+
+    SpirvCodeBuffer code = shader->getCode();
+    result.codeSize = code.size();
+
+    for (auto ins : code) {
+      (void) ins;
+      result.insCount += 1;
+    }
+
+    result.success = true;
+  } catch (const DxvkError& e) {
+    Logger::err(str::format(name, ": ", e.message()));
+  }
+
+  return result;
+}
+
+
+/**
+ * \brief Reads results from a CSV file
+ *
+ * \param [in] fileName File name
+ * \param [out] results Results
+ * \returns \c true on success
+ */
+bool readResults(const std::string& fileName, BenchmarkResults& results) {
+  std::ifstream file(fileName);
+
+  if (!file)
+    return false;
+
+  std::string line;
+  std::getline(file, line);
+
+  while (std::getline(file, line)) {
+    std::stringstream stream(line);
+    std::string shaderName, configName, success;
+
+    BenchmarkResult result;
+
+    std::getline(stream, shaderName, ',');
+    std::getline(stream, configName, ',');
+    std::getline(stream, success, ',');
+
+    char sep;
+    stream >> result.timeUs >> sep >> result.codeSize >> sep >> result.insCount;
+
+    result.success = success == "1";
+    results[{ shaderName, configName }] = result;
+  }
+
+  return true;
+}
+
+
+/**
+ * \brief Writes results to a CSV file
+ *
+ * \param [in] fileName File name
+ * \param [in] results Results
+ * \returns \c true on success
+ */
+bool writeResults(const std::string& fileName, const BenchmarkResults& results) {
+  std::ofstream file(fileName, std::ios_base::trunc);
+  file << "shader,options,success,time_us,size,instructions" << std::endl;
+
+  for (const auto& r : results) {
+    file << r.first.first << ","
+         << r.first.second << ","
+         << (r.second.success ? 1 : 0) << ","
+         << r.second.timeUs << ","
+         << r.second.codeSize << ","
+         << r.second.insCount << std::endl;
+  }
+
+  return bool(file);
+}
+
+
+/**
+ * \brief Compares results against a baseline
+ *
+ * Shaders which no longer compile, or which produce more
+ * SPIR-V instructions than before, are regressions. Time
+ * differences are only reported since they are too noisy
+ * to be used as a pass or fail criterion.
+ * \param [in] results Current results
+ * \param [in] baseline Baseline results
+ * \returns Number of regressions
+ */
+uint32_t compareResults(const BenchmarkResults& results, const BenchmarkResults& baseline) {
+  uint32_t regressions = 0;
+
+  std::map<std::string, std::pair<uint64_t, uint64_t>> times;
+
+  for (const auto& r : results) {
+    auto b = baseline.find(r.first);
+
+    if (b == baseline.end())
+      continue;
+
+    std::string name = r.first.first + " (" + r.first.second + ")";
+
+    if (b->second.success && !r.second.success) {
+      std::cout << "  " << name << ": Compilation failed" << std::endl;
+      regressions += 1;
+      continue;
+    }
+
+    if (!b->second.success || !r.second.success)
+      continue;
+
+    if (r.second.insCount != b->second.insCount) {
+      std::cout << "  " << name << ": "
+        << b->second.insCount << " -> " << r.second.insCount << " instructions" << std::endl;
+
+      if (r.second.insCount > b->second.insCount)
+        regressions += 1;
+    }
+
+    times[r.first.second].first  += b->second.timeUs;
+    times[r.first.second].second += r.second.timeUs;
+  }
+
+  for (const auto& t : times) {
+    std::cout << "  " << t.first << ": " << t.second.first << " us -> "
+      << t.second.second << " us" << std::endl;
+  }
+
+  return regressions;
+}
+
+
+int main(int argc, char** argv) {
+  std::string path;
+  std::string baselineFile;
+  std::string outputFile;
+
+  uint32_t iterations = 5;
+
+  for (int i = 1; i < argc; i++) {
+    if (!std::strcmp(argv[i], "-b") && i + 1 < argc)
+      baselineFile = argv[++i];
+    else if (!std::strcmp(argv[i], "-o") && i + 1 < argc)
+      outputFile = argv[++i];
+    else if (!std::strcmp(argv[i], "-n") && i + 1 < argc)
+      iterations = std::max(std::atoi(argv[++i]), 1);
+    else
+      path = argv[i];
+  }
+
+  if (path.empty()) {
+    std::cerr << "Usage: dxbc-benchmark [-n iterations] [-b baseline.csv] [-o results.csv] directory" << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> shaders = listShaders(path);
+
+  if (shaders.empty()) {
+    std::cerr << "No DXBC files found in " << path << std::endl;
+    return 1;
+  }
+
+  std::vector<BenchmarkConfig> configs = getConfigs();
+
+  BenchmarkResults results;
+
+  std::cout << "Shader                                  Options     Time (us)  Size (bytes)  Instructions" << std::endl;
+
+  for (const auto& shaderName : shaders) {
+    std::ifstream file(path + "/" + shaderName, std::ios_base::binary);
+    std::vector<char> dxbcCode(
+      (std::istreambuf_iterator<char>(file)),
+      (std::istreambuf_iterator<char>()));
+
+    std::string name = shaderName.substr(0, shaderName.size() - 5);
+
+    for (const auto& config : configs) {
+      BenchmarkResult result = compileShader(dxbcCode, name, config, iterations);
+      results[{ name, config.name }] = result;
+
+      std::cout << std::left
+        << std::setw(40) << name << std::setw(12) << config.name;
+
+      if (result.success) {
+        std::cout << std::setw(11) << result.timeUs
+          << std::setw(14) << result.codeSize << result.insCount << std::endl;
+      } else {
+        std::cout << "failed" << std::endl;
+      }
+    }
+  }
+
+  std::cout << std::endl << "Total:" << std::endl;
+
+  for (const auto& config : configs) {
+    BenchmarkResult total;
+    uint32_t failed = 0;
+
+    for (const auto& r : results) {
+      if (r.first.second != config.name)
+        continue;
+
+      if (!r.second.success) {
+        failed += 1;
+        continue;
+      }
+
+      total.timeUs   += r.second.timeUs;
+      total.codeSize += r.second.codeSize;
+      total.insCount += r.second.insCount;
+    }
+
+    std::cout << "  " << config.name << ": "
+      << total.timeUs   << " us, "
+      << total.codeSize << " bytes, "
+      << total.insCount << " instructions, "
+      << failed         << " failed" << std::endl;
+  }
+
+  if (!outputFile.empty() && !writeResults(outputFile, results)) {
+    std::cerr << "Failed to write " << outputFile << std::endl;
+    return 1;
+  }
+
+  if (!baselineFile.empty()) {
+    BenchmarkResults baseline;
+
+    if (!readResults(baselineFile, baseline)) {
+      std::cerr << "Failed to read " << baselineFile << std::endl;
+      return 1;
+    }
+
+    std::cout << std::endl << "Compared to baseline:" << std::endl;
+    uint32_t regressions = compareResults(results, baseline);
+    std::cout << regressions << " regressions" << std::endl;
+    return regressions ? 1 : 0;
+  }
+
+  return 0;
+}
@@ -0,0 +1,273 @@
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#include "../../src/dxvk/dxvk_state_cache.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("dxvk-state-cache.log");
+}
+
+using namespace dxvk;
+
+struct StateCacheFile {
+  std::vector<DxvkStateCacheEntry> entries;
+  uint32_t                         session = 0;
+};
+
+struct StateCacheStats {
+  uint32_t numRead       = 0;
+  uint32_t numInvalid    = 0;
+  uint32_t numDuplicates = 0;
+  uint32_t numPruned     = 0;
+};
+
+using StateCacheEntryMap = std::unordered_multimap<
+  DxvkStateCacheKey, size_t, DxvkHash, DxvkEq>;
+
+
+bool isNullShaderKey(const DxvkShaderKey& key) {
+  return key.eq(DxvkShaderKey());
+}
+
+
+bool isValidEntry(const DxvkStateCacheEntry& entry) {
+  // Compute entries must not reference graphics
+  // shaders, graphics entries need a vertex shader
+  if (!isNullShaderKey(entry.shaders.cs)) {
+    return isNullShaderKey(entry.shaders.vs)
+        && isNullShaderKey(entry.shaders.tcs)
+        && isNullShaderKey(entry.shaders.tes)
+        && isNullShaderKey(entry.shaders.gs)
+        && isNullShaderKey(entry.shaders.fs);
+  }
+
+  return !isNullShaderKey(entry.shaders.vs)
+      && entry.gpState.ilAttributeCount <= DxvkLimits::MaxNumVertexAttributes
+      && entry.gpState.ilBindingCount   <= DxvkLimits::MaxNumVertexBindings;
+}
+
+
+DxvkStateCacheEntry* findEntry(
+        std::vector<DxvkStateCacheEntry>& entries,
+  const StateCacheEntryMap&               entryMap,
+  const DxvkStateCacheEntry&              entry) {
+  auto range = entryMap.equal_range(entry.shaders);
+
+  for (auto e = range.first; e != range.second; e++) {
+    DxvkStateCacheEntry& other = entries[e->second];
+
+    if (other.format.matches(entry.format)
+     && other.gpState == entry.gpState
+     && other.cpState == entry.cpState)
+      return &other;
+  }
+
+  return nullptr;
+}
+
+
+bool readFile(
+  const std::string&      fileName,
+        StateCacheFile&   file,
+        StateCacheStats&  stats) {
+  std::ifstream ifile(fileName, std::ios_base::binary);
+
+  if (!ifile) {
+    Logger::err(str::format(fileName, ": Failed to open file"));
+    return false;
+  }
+
+  DxvkStateCacheHeader header;
+
+  if (!DxvkStateCache::readCacheHeader(ifile, header)) {
+    Logger::err(str::format(fileName, ": Not a state cache file"));
+    return false;
+  }
+
+  size_t entrySize = DxvkStateCache::getCacheEntrySize(header.version);
+
+  if (!entrySize || header.entrySize != entrySize) {
+    Logger::err(str::format(fileName, ": Unsupported state cache version ", header.version));
+    return false;
+  }
+
+  StateCacheEntryMap entryMap;
+
+  while (ifile) {
+    DxvkStateCacheEntry entry;
+
+    bool valid = header.version < 4
+      ? DxvkStateCache::readCacheEntryV3(ifile, entry)
+      : DxvkStateCache::readCacheEntry  (ifile, entry);
+
+    if (!valid) {
+      if (ifile)
+        stats.numInvalid += 1;
+      continue;
+    }
+
+    if (header.version == 2)
+      DxvkStateCache::convertEntryV2(entry);
+
+    stats.numRead += 1;
+
+    if (!isValidEntry(entry)) {
+      stats.numInvalid += 1;
+      continue;
+    }
+
+    file.session = std::max(file.session, entry.usage.session);
+
+    // Within one file, duplicates are either usage updates
+    // appended by DXVK or leftovers from older versions
+    DxvkStateCacheEntry* existing = findEntry(file.entries, entryMap, entry);
+
+    if (existing != nullptr) {
+      existing->usage.session = std::max(existing->usage.session, entry.usage.session);
+      existing->usage.count   = std::max(existing->usage.count,   entry.usage.count);
+      stats.numDuplicates += 1;
+    } else {
+      entryMap.insert({ entry.shaders, file.entries.size() });
+      file.entries.push_back(entry);
+    }
+  }
+
+  return true;
+}
+
+
+void pruneFile(
+        StateCacheFile&   file,
+        StateCacheStats&  stats,
+        uint32_t          numSessions) {
+  std::vector<DxvkStateCacheEntry> entries;
+
+  // Entries without usage info were written by older
+  // DXVK versions, so we cannot tell when they were
+  // used for the last time. Keep them to be safe.
+  for (const auto& entry : file.entries) {
+    if (entry.usage.count == 0
+     || entry.usage.session + numSessions > file.session)
+      entries.push_back(entry);
+    else
+      stats.numPruned += 1;
+  }
+
+  file.entries = std::move(entries);
+}
+
+
+void mergeFile(
+        StateCacheFile&     dst,
+        StateCacheEntryMap& dstMap,
+  const StateCacheFile&     src,
+        uint32_t            session,
+        StateCacheStats&    stats) {
+  for (auto entry : src.entries) {
+    // Session numbers are local to each cache file, so we
+    // need to rebase them relative to the latest session
+    if (entry.usage.count != 0)
+      entry.usage.session = session - (src.session - entry.usage.session);
+
+    DxvkStateCacheEntry* existing = findEntry(dst.entries, dstMap, entry);
+
+    if (existing != nullptr) {
+      existing->usage.session = std::max(existing->usage.session, entry.usage.session);
+      existing->usage.count  += entry.usage.count;
+      stats.numDuplicates += 1;
+    } else {
+      dstMap.insert({ entry.shaders, dst.entries.size() });
+      dst.entries.push_back(entry);
+    }
+  }
+}
+
+
+bool writeFile(
+  const std::string&      fileName,
+        StateCacheFile&   file) {
+  std::ofstream ofile(fileName,
+    std::ios_base::binary |
+    std::ios_base::trunc);
+
+  if (!ofile) {
+    Logger::err(str::format(fileName, ": Failed to create file"));
+    return false;
+  }
+
+  DxvkStateCacheHeader header;
+
+  ofile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+  for (auto& entry : file.entries)
+    DxvkStateCache::writeCacheEntry(ofile, entry);
+
+  return bool(ofile);
+}
+
+
+int main(int argc, char** argv) {
+  std::vector<std::string> inputFiles;
+  std::string              outputFile;
+  uint32_t                 numSessions = 0;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+
+    if (arg == "-o" && i + 1 < argc) {
+      outputFile = argv[++i];
+    } else if (arg == "-p" && i + 1 < argc) {
+      try {
+        numSessions = std::stoul(argv[++i]);
+      } catch (const std::exception&) {
+        numSessions = 0;
+      }
+
+      if (!numSessions) {
+        Logger::err("Session count must be a positive number");
+        return 1;
+      }
+    } else {
+      inputFiles.push_back(arg);
+    }
+  }
+
+  if (inputFiles.empty() || outputFile.empty()) {
+    Logger::err("Usage: dxvk-state-cache [-p sessions] -o output.dxvk-cache input.dxvk-cache...");
+    return 1;
+  }
+
+  std::vector<StateCacheFile> files(inputFiles.size());
+  StateCacheStats             stats;
+
+  uint32_t session = 0;
+
+  for (size_t i = 0; i < inputFiles.size(); i++) {
+    if (!readFile(inputFiles[i], files[i], stats))
+      return 1;
+
+    if (numSessions)
+      pruneFile(files[i], stats, numSessions);
+
+    session = std::max(session, files[i].session);
+  }
+
+  StateCacheFile     merged;
+  StateCacheEntryMap mergedMap;
+
+  for (const auto& file : files)
+    mergeFile(merged, mergedMap, file, session, stats);
+
+  merged.session = session;
+
+  if (!writeFile(outputFile, merged))
+    return 1;
+
+  Logger::info(str::format("Read ", stats.numRead, " entries from ", inputFiles.size(), " files"));
+  Logger::info(str::format("Dropped ", stats.numInvalid, " invalid entries"));
+  Logger::info(str::format("Merged ", stats.numDuplicates, " duplicate entries"));
+  Logger::info(str::format("Pruned ", stats.numPruned, " unused entries"));
+  Logger::info(str::format("Wrote ", merged.entries.size(), " entries to ", outputFile));
+  return 0;
+}
@@ -0,0 +1,57 @@
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "../../src/spirv/spirv_compression.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-compression.log");
+}
+
+using namespace dxvk;
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    std::cerr << "Usage: spirv-compression input.spv..." << std::endl;
+    return 1;
+  }
+
+  size_t totalSize       = 0;
+  size_t totalCompressed = 0;
+  bool   success         = true;
+
+  for (int i = 1; i < argc; i++) {
+    std::ifstream ifile(argv[i], std::ios::binary);
+
+    if (!ifile) {
+      std::cerr << "Failed to read " << argv[i] << std::endl;
+      success = false;
+      continue;
+    }
+
+    SpirvCodeBuffer code(ifile);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    SpirvCompressedBuffer compressed(code);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    SpirvCodeBuffer decompressed = compressed.decompress();
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    // Decompression must restore the original code exactly
+    bool match = decompressed.size() == code.size()
+      && (!code.size() || !std::memcmp(decompressed.data(), code.data(), code.size()));
+
+    std::cout << argv[i] << ": " << code.size() << " -> " << compressed.size() << " bytes, "
+      << std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count() << " us / "
+      << std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count() << " us"
+      << (match ? "" : ", mismatch") << std::endl;
+
+    totalSize       += code.size();
+    totalCompressed += compressed.size();
+    success         &= match;
+  }
+
+  std::cout << "Total: " << totalSize << " -> " << totalCompressed << " bytes" << std::endl;
+  return success ? 0 : 1;
+}
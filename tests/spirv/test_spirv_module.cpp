@@ -0,0 +1,118 @@
+#include <chrono>
+#include <iostream>
+
+#include "../../src/spirv/spirv_module.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-module.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Declares types and constants
+ * 
+ * Emulates a large shader which declares lots
+ * of distinct constants and uses many of them
+ * repeatedly, as large uber-shaders tend to do.
+ * \param [in] declCount Number of distinct constants
+ * \returns Size of the resulting module, in bytes
+ */
+size_t buildSyntheticModule(uint32_t declCount) {
+  SpirvModule module;
+  
+  for (uint32_t i = 0; i < declCount; i++) {
+    uint32_t intType = module.defIntType(32, 0);
+    module.defVectorType(intType, 4);
+    module.defArrayType(intType, module.constu32(i + 1));
+    
+    module.constu32(i);
+    module.constf32(float(i));
+    module.constvec4u32(i, i + 1, i + 2, i + 3);
+    
+    // Look up some previously declared constants
+    module.constu32(i / 2);
+    module.constf32(float(i / 4));
+  }
+  
+  return module.compile().size();
+}
+
+
+/**
+ * \brief Inserts code into a code buffer
+ * 
+ * Emulates the way structured control flow is emitted,
+ * where header instructions are written to a previous
+ * location once the block ends. Builds a switch block
+ * with the given number of cases, each of which has
+ * an if block, and inserts the case list last.
+ * \param [in] caseCount Number of switch cases
+ * \returns Size of the resulting code, in bytes
+ */
+size_t buildInsertedCode(uint32_t caseCount) {
+  SpirvCodeBuffer code;
+  
+  size_t switchPtr = code.getInsertionPtr();
+  
+  for (uint32_t i = 0; i < caseCount; i++) {
+    size_t ifPtr = code.getInsertionPtr();
+    
+    for (uint32_t j = 0; j < 16; j++)
+      code.putWord(j);
+    
+    code.beginInsertion(ifPtr);
+    code.putIns(spv::OpSelectionMerge, 3);
+    code.putWord(i);
+    code.putWord(0);
+    code.endInsertion();
+  }
+  
+  code.beginInsertion(switchPtr);
+  code.putIns(spv::OpSwitch, 3 + 2 * caseCount);
+  code.putWord(0);
+  code.putWord(0);
+  
+  for (uint32_t i = 0; i < caseCount; i++) {
+    code.putWord(i);
+    code.putWord(i);
+  }
+  
+  code.endInsertion();
+  return code.size();
+}
+
+
+int main(int argc, char** argv) {
+  std::cout << "Declarations     Time (ms)     Time per declaration (ns)" << std::endl;
+  
+  for (uint32_t declCount = 1000; declCount <= 64000; declCount *= 4) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    size_t size = buildSyntheticModule(declCount);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    
+    auto td = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+    
+    std::cout << declCount
+      << "\t\t " << (td.count() / 1000000)
+      << "\t\t" << (td.count() / (8 * declCount))
+      << "\t(" << size << " bytes)" << std::endl;
+  }
+  
+  std::cout << std::endl << "Switch cases     Time (ms)     Time per case (ns)" << std::endl;
+  
+  for (uint32_t caseCount = 1000; caseCount <= 64000; caseCount *= 4) {
+    auto t0 = std::chrono::high_resolution_clock::now();
+    size_t size = buildInsertedCode(caseCount);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    
+    auto td = std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0);
+    
+    std::cout << caseCount
+      << "\t\t " << (td.count() / 1000000)
+      << "\t\t" << (td.count() / caseCount)
+      << "\t(" << size << " bytes)" << std::endl;
+  }
+  
+  return 0;
+}
@@ -0,0 +1,58 @@
+#include <fstream>
+#include <iostream>
+
+#include "../../src/spirv/spirv_optimizer.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-optimizer.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Counts instructions in a module
+ *
+ * \param [in] code The module
+ * \returns Number of instructions
+ */
+size_t countInstructions(SpirvCodeBuffer& code) {
+  size_t result = 0;
+
+  for (auto i = code.begin(); i != code.end(); ++i)
+    result += 1;
+
+  return result;
+}
+
+
+int main(int argc, char** argv) {
+  if (argc < 2 || argc > 3) {
+    std::cerr << "Usage: spirv-optimizer input.spv [output.spv]" << std::endl;
+    return 1;
+  }
+
+  std::ifstream ifile(argv[1], std::ios::binary);
+
+  if (!ifile) {
+    std::cerr << "Failed to read " << argv[1] << std::endl;
+    return 1;
+  }
+
+  SpirvCodeBuffer code(ifile);
+
+  size_t sizeBefore = code.size();
+  size_t insBefore  = countInstructions(code);
+
+  if (!SpirvOptimizer().optimize(code))
+    std::cout << "Module was not changed" << std::endl;
+
+  std::cout << "Size:         " << sizeBefore << " -> " << code.size() << " bytes" << std::endl;
+  std::cout << "Instructions: " << insBefore  << " -> " << countInstructions(code) << std::endl;
+
+  if (argc == 3) {
+    std::ofstream ofile(argv[2], std::ios::binary);
+    code.store(ofile);
+  }
+
+  return 0;
+}
@@ -0,0 +1,61 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+#include "../../src/spirv/spirv_output_pruner.h"
+
+namespace dxvk {
+  Logger Logger::s_instance("spirv-output-pruner.log");
+}
+
+using namespace dxvk;
+
+/**
+ * \brief Counts output variables in a module
+ *
+ * \param [in] code The module
+ * \returns Number of output variables
+ */
+uint32_t countOutputs(SpirvCodeBuffer& code) {
+  uint32_t result = 0;
+
+  for (auto ins : code) {
+    if (ins.opCode() == spv::OpVariable
+     && ins.arg(3) == spv::StorageClassOutput)
+      result += 1;
+  }
+
+  return result;
+}
+
+
+int main(int argc, char** argv) {
+  if (argc < 3 || argc > 4) {
+    std::cerr << "Usage: spirv-output-pruner input.spv location-mask [output.spv]" << std::endl;
+    return 1;
+  }
+
+  std::ifstream ifile(argv[1], std::ios::binary);
+
+  if (!ifile) {
+    std::cerr << "Failed to read " << argv[1] << std::endl;
+    return 1;
+  }
+
+  SpirvCodeBuffer code(ifile);
+
+  uint32_t locationMask  = std::strtoul(argv[2], nullptr, 0);
+  uint32_t outputsBefore = countOutputs(code);
+
+  if (!SpirvOutputPruner().prune(code, locationMask))
+    std::cout << "Module was not changed" << std::endl;
+
+  std::cout << "Outputs: " << outputsBefore << " -> " << countOutputs(code) << std::endl;
+
+  if (argc == 4) {
+    std::ofstream ofile(argv[3], std::ios::binary);
+    code.store(ofile);
+  }
+
+  return 0;
+}